@@ -1,6 +1,9 @@
 #include "ASTParser.h"
+#include <algorithm>
 #include "Private/Internal/BaseParser.h"
 #include "Private/Internal/BTNode.h"
+#include "GrammarProgram.h"
+#include "PackratMemo.h"
 
 namespace ReParser::AST
 {
@@ -8,20 +11,267 @@ namespace ReParser::AST
     DEFINE_CLASS_WITHOUT_NEW(ASTNodeParser)
     DEFINE_CLASS_WITHOUT_NEW(ASTParser)
 
+    // inserts value into the sorted values
+    static bool InsertSorted(Re::Vector<int32>& values, int32 value)
+    {
+        auto it = std::lower_bound(values.begin(), values.end(), value);
+        if(it != values.end() && *it == value)
+        {
+            return false;
+        }
+        values.insert(it, value);
+        return true;
+    }
+
+    bool FirstSet::Contains(const Token& token) const
+    {
+        if(bAny)
+        {
+            return true;
+        }
+        const int32 atom = token.GetAtomId();
+        const int32 terminal = token.GetTerminalId();
+        return (atom != 0 && std::binary_search(Atoms.begin(), Atoms.end(), atom))
+            || (terminal != 0 && std::binary_search(Terminals.begin(), Terminals.end(), terminal));
+    }
+
+    bool FirstSet::Merge(const FirstSet& other)
+    {
+        bool bGrew = other.bAny && AddAny();
+        for (int32 atom : other.Atoms)
+        {
+            bGrew |= AddAtom(atom);
+        }
+        for (int32 terminal : other.Terminals)
+        {
+            bGrew |= AddTerminal(terminal);
+        }
+        return bGrew;
+    }
+
+    bool FirstSet::AddAtom(int32 atom)
+    {
+        return InsertSorted(Atoms, atom);
+    }
+
+    bool FirstSet::AddTerminal(int32 terminal)
+    {
+        return InsertSorted(Terminals, terminal);
+    }
+
+    bool FirstSet::AddAny()
+    {
+        const bool bGrew = !bAny;
+        bAny = true;
+        return bGrew;
+    }
+
+    void ASTNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        compiler.EmitNative(*this);
+    }
+
+    bool ASTNodeParser::UpdateFirst()
+    {
+        // a parser written in C++ may start with anything, it is tried on every token
+        return First.AddAny();
+    }
+
     bool ASTTree::Parse(ASTNodeParser& parser, ICodeFile* file, ASTParser& context, const Token& token)
     {
-        return parser.Parse(file, context, token, &Root);
+        ASTNodePtr root;
+        if(!context.ParseRule(parser, file, token, &root))
+        {
+            return false;
+        }
+        Root = root;
+        return true;
     }
 
     Re::String ASTTree::ToString() const
     {
+        if(!Root)
+        {
+            return "";
+        }
         BTTree<ASTNode> Printer(Re::SharedPtrGet(Root), &ASTNode::GetChildNodesWithListNonConst, &ASTNode::ToStringNonConst);
         return Printer.toString();
     }
 
     bool ASTParser::CompileDeclaration(ICodeFile* file, const Token& token)
     {
-        return Tree.Parse(*Lexer, file, *this, token);
+        if(Memo)
+        {
+            Memo->Reset();
+        }
+        bool bParsed;
+        if(bUseBytecode && IsPreTokenized() && GetAtoms())
+        {
+            if(!VM)
+            {
+                VM = Re::MakeShared<GrammarVM>();
+            }
+            ASTNodePtr root;
+            bParsed = VM->Run(*GetProgram(), file, *this, token, &root);
+            if(bParsed)
+            {
+                Tree.SetRoot(root);
+            }
+        }
+        else
+        {
+            bParsed = Tree.Parse(*Lexer, file, *this, token);
+        }
+
+        if(!bParsed)
+        {
+            ResetToToken(token);
+            return false;
+        }
+        if(InputPos <= token.GetStartPos())
+        {
+            // matched nothing, step over token so the next declaration makes progress
+            ResetToToken(token);
+        }
+        return true;
+    }
+
+    const GrammarProgram* ASTParser::GetProgram()
+    {
+        if(!Program)
+        {
+            Program = GrammarProgram::Compile(*Lexer, *GetAtoms());
+        }
+        return Re::SharedPtrGet(Program);
+    }
+
+    void ASTParser::SetPackratMemoEntries(int32 maxEntries)
+    {
+        Memo = maxEntries > 0 ? Re::MakeShared<PackratMemo>(maxEntries) : nullptr;
+    }
+
+    bool ASTParser::ParseRule(ASTNodeParser& rule, ICodeFile* file, const Token& token, ASTNodePtr* outNode)
+    {
+        if(rule.IsDefinedParser())
+        {
+            RuleCallNum++;
+        }
+        const ELeftRecursion leftRecursion = rule.GetLeftRecursion();
+        const bool bMemoize = Memo && rule.IsDefinedParser() && leftRecursion != ELeftRecursion::Involved;
+        if(!IsPreTokenized() && leftRecursion == ELeftRecursion::Leader)
+        {
+            // seeds are kept by token index, parsing the rule anyway would recurse until the stack overflows
+            Report(EDiagnosticCode::ASTLeftRecursionNotPreTokenized, { rule.GetName() });
+            return false;
+        }
+        if(!IsPreTokenized() || (!bMemoize && leftRecursion != ELeftRecursion::Leader))
+        {
+            return rule.Parse(file, *this, token, outNode);
+        }
+        const int32 pos = GetPreTokenIndex(token);
+        if(bMemoize)
+        {
+            if(auto entry = Memo->Find(rule, pos))
+            {
+                if(!entry->bParsed)
+                {
+                    return false;
+                }
+                *outNode = entry->Node;
+                SetPreTokenCursor(entry->EndPos);
+                return true;
+            }
+        }
+
+        bool bParsed;
+        if(leftRecursion == ELeftRecursion::Leader)
+        {
+            bParsed = GrowSeed(rule, file, token, pos, outNode);
+            // another leader of the cycle growing at pos still changes what this one matches
+            if(IsGrowingAt(pos))
+            {
+                return bParsed;
+            }
+        }
+        else
+        {
+            bParsed = rule.Parse(file, *this, token, outNode);
+        }
+        if(bMemoize)
+        {
+            Memo->Store(rule, pos, bParsed, bParsed ? GetPreTokenCursor() : pos, bParsed ? *outNode : nullptr);
+        }
+        return bParsed;
+    }
+
+    bool ASTParser::GrowSeed(ASTNodeParser& rule, ICodeFile* file, const Token& token, int32 pos, ASTNodePtr* outNode)
+    {
+        if(auto seed = FindSeed(rule, pos))
+        {
+            // the left-recursive call, reads the result of the last pass
+            if(!seed->bParsed)
+            {
+                return false;
+            }
+            *outNode = seed->Node;
+            SetPreTokenCursor(seed->EndPos);
+            return true;
+        }
+
+        Seeds.push_back({ &rule, pos, false, pos, nullptr });
+        const size_t seedIndex = Seeds.size() - 1;
+        while(true)
+        {
+            ASTNodePtr node;
+            if(!rule.Parse(file, *this, token, &node))
+            {
+                break;
+            }
+            const int32 endPos = GetPreTokenCursor();
+            LeftRecursionSeed& seed = Seeds[seedIndex];
+            if(seed.bParsed && endPos <= seed.EndPos)
+            {
+                break;
+            }
+            seed.bParsed = true;
+            seed.EndPos = endPos;
+            seed.Node = node;
+            ResetToToken(token);
+        }
+
+        LeftRecursionSeed seed = std::move(Seeds[seedIndex]);
+        Seeds.pop_back();
+        if(!seed.bParsed)
+        {
+            return false;
+        }
+        *outNode = seed.Node;
+        SetPreTokenCursor(seed.EndPos);
+        return true;
+    }
+
+    LeftRecursionSeed* ASTParser::FindSeed(const ASTNodeParser& rule, int32 pos)
+    {
+        for (auto& seed : Seeds)
+        {
+            if(seed.Rule == &rule && seed.Pos == pos)
+            {
+                return &seed;
+            }
+        }
+        return nullptr;
+    }
+
+    bool ASTParser::IsGrowingAt(int32 pos) const
+    {
+        for (auto& seed : Seeds)
+        {
+            if(seed.Pos == pos)
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
     void ASTParser::AddCustomParser(const Re::String& name, const Re::SharedPtr<ASTNodeParser>& parser)
@@ -1,10 +1,11 @@
 #include "BNFParser.h"
 #include "ReClassMisc.h"
+#include "ASTParser/LeftRecursion.h"
 #include "ASTParser/Parsers.h"
 
 namespace ReParser::BNF
 {
-    class BNFParser : public BaseParserWithFile
+    class BNFParser : public TBaseParser<DefaultLexPolicy, BaseParserWithFile>
     {
         enum class ParseState
         {
@@ -14,9 +15,15 @@ namespace ReParser::BNF
         };
 
         bool CompileDeclaration(ICodeFile* file, const Token& token) override;
+        void PostParserProcess(ICodeFile* file) override;
     private:
 
         bool ParseGlobal(BNFFile& file, const Token& token);
+        bool ParseDirective(BNFFile& file);
+        bool ParseTokenDirective(BNFFile& file, int64 currentLine);
+        bool ParseKeywordDirective(BNFFile& file, int64 currentLine);
+        bool ParseOperatorDirective(BNFFile& file, int64 currentLine);
+        bool ParsePrecedenceDirective(BNFFile& file, int64 currentLine, AST::EOperatorAssociativity associativity);
         bool ParseLeft(BNFFile& file, const Token& token);
         bool ParseRight(BNFFile& file, const Token& token);
         bool ParseASTParserGroup(BNFFile& file, const Token& token, Re::SharedPtr<AST::GroupNodeParser>& outParser);
@@ -24,26 +31,58 @@ namespace ReParser::BNF
 
     private:
 
-        int32 LastLine = 0;
+        int64 LastLine = 0;
         ParseState CurrentState = ParseState::Global;
         Re::Stack<Re::WeakPtr<AST::ASTNodeParser>> ParserStack;
     };
 
     DEFINE_DERIVED_CLASS_WITHOUT_NEW(BNFFile, ICodeFile)
 
-    Re::SharedPtr<BNFFile> BNFFile::Parse(const Re::String& filePath)
+    // directives of a precedence level and their associativity
+    static const Re::Map<Re::String, AST::EOperatorAssociativity>& GetPrecedenceDirectives()
+    {
+        static const Re::Map<Re::String, AST::EOperatorAssociativity> Directives = {
+            { "left", AST::EOperatorAssociativity::Left },
+            { "right", AST::EOperatorAssociativity::Right },
+            { "nonassoc", AST::EOperatorAssociativity::NonAssoc },
+        };
+        return Directives;
+    }
+
+    // kind names of %token
+    static const Re::Map<Re::String, ETokenPatternKind>& GetTokenPatternKinds()
+    {
+        static const Re::Map<Re::String, ETokenPatternKind> Kinds = {
+            { "skip", ETokenPatternKind::Skip },
+            { "identifier", ETokenPatternKind::Identifier },
+            { "symbol", ETokenPatternKind::Symbol },
+            { "number", ETokenPatternKind::Number },
+            { "string", ETokenPatternKind::String },
+        };
+        return Kinds;
+    }
+
+    static Re::SharedPtr<BNFFile> ParseFile(const Re::String& filePath, Re::String& outError)
     {
         auto result = Re::MakeShared<BNFFile>(filePath);
         if(!result->IsValid())
         {
+            outError = RE_FORMAT("read bnf file %s failed !!", filePath.c_str());
             return nullptr;
         }
         BNFParser parser;
-        parser.InitParserSource(result->GetFilePath(), result->GetContent().c_str());
+        parser.InitParserSource(result->GetFilePath(), result->GetContent().data(), static_cast<int64>(result->GetContent().size()));
         parser.Parse(Re::SharedPtrGet(result));
+        parser.GetError(outError);
         return result;
     }
 
+    Re::SharedPtr<BNFFile> BNFFile::Parse(const Re::String& filePath)
+    {
+        Re::String error;
+        return ParseFile(filePath, error);
+    }
+
     Re::SharedPtr<BNFFile> BNFFile::Parse(const Re::String& filePath, const Re::String& content)
     {
         auto result = Re::MakeShared<BNFFile>(filePath, content);
@@ -52,11 +91,22 @@ namespace ReParser::BNF
             return nullptr;
         }
         BNFParser parser;
-        parser.InitParserSource(result->GetFilePath(), result->GetContent().c_str());
+        parser.InitParserSource(result->GetFilePath(), result->GetContent().data(), static_cast<int64>(result->GetContent().size()));
         parser.Parse(Re::SharedPtrGet(result));
         return result;
     }
 
+    Re::Vector<FileParseResult<BNFFile>> BNFFile::ParseBatch(const Re::Vector<Re::String>& filePaths, WorkStealingPool& pool)
+    {
+        Re::Vector<FileParseResult<BNFFile>> results(filePaths.size());
+        pool.ParallelFor(static_cast<int32>(filePaths.size()), [&](int32 index)
+        {
+            auto& result = results[static_cast<size_t>(index)];
+            result.File = ParseFile(filePaths[static_cast<size_t>(index)], result.Error);
+        });
+        return results;
+    }
+
     bool BNFFile::AppendRule(const Re::String& ruleName, Re::SharedPtr<AST::ASTNodeParser>* outParserPtr)
     {
         auto it = RuleLexers.find(ruleName);
@@ -97,6 +147,37 @@ namespace ReParser::BNF
         }
     }
 
+    bool BNFFile::AppendTokenPattern(const TokenPattern& pattern)
+    {
+        if(FindTokenPattern(pattern.Name) >= 0 || RuleLexers.find(pattern.Name) != RuleLexers.end())
+        {
+            return false;
+        }
+        TokenPatterns.push_back(pattern);
+        return true;
+    }
+
+    void BNFFile::AppendPrecedenceLevel(AST::EOperatorAssociativity associativity, const Re::Vector<Re::String>& operators)
+    {
+        PrecedenceLevelNum++;
+        for (auto& op : operators)
+        {
+            BinaryOperators.push_back({ op, PrecedenceLevelNum, associativity });
+        }
+    }
+
+    int32 BNFFile::FindTokenPattern(const Re::String& name) const
+    {
+        for (size_t i = 0; i < TokenPatterns.size(); i++)
+        {
+            if(TokenPatterns[i].Name == name)
+            {
+                return static_cast<int32>(i);
+            }
+        }
+        return -1;
+    }
+
     Re::SharedPtr<AST::ASTParser> BNFFile::GenerateASTParser() const
     {
         auto it = GetRuleLexers().find("root");
@@ -106,6 +187,44 @@ namespace ReParser::BNF
             return nullptr;
         }
         auto result = Re::MakeShared<AST::ASTParser>(it->second);
+        if(!TokenPatterns.empty())
+        {
+            Re::String error;
+            auto lexer = DFALexer::Build(TokenPatterns, error);
+            if(!lexer)
+            {
+                RE_ERROR_F("build token lexer failed, %s !! %s", error.c_str(), GetFilePath().c_str());
+                return nullptr;
+            }
+            result->SetTableLexer(lexer);
+        }
+        if(!Keywords.empty())
+        {
+            result->SetKeywords(Re::MakeShared<KeywordTable>(Keywords));
+        }
+        if(!Operators.empty())
+        {
+            result->SetOperators(Re::MakeShared<OperatorTable>(Operators));
+        }
+        // literals are interned in the same order for every parser, so the atoms stored in the shared rules hold for all of them
+        for (auto& lexer : RuleLexers)
+        {
+            lexer.second->ResolveAtoms(*result->GetAtoms());
+        }
+        // first sets are made of atoms, every pass only grows them so they settle once a pass changes nothing
+        bool bGrew = true;
+        while (bGrew)
+        {
+            bGrew = false;
+            for (auto& lexer : RuleLexers)
+            {
+                bGrew |= lexer.second->UpdateFirst();
+            }
+        }
+        for (auto& lexer : RuleLexers)
+        {
+            lexer.second->BuildDispatch();
+        }
 
         return result;
     }
@@ -115,6 +234,73 @@ namespace ReParser::BNF
     {
         Re::String Result;
         bool isFirst = true;
+        for (auto& pattern : TokenPatterns)
+        {
+            if(!isFirst)
+            {
+                Result += "\n";
+            }
+            Result += "\t\t\t\t%token ";
+            for (auto& kind : GetTokenPatternKinds())
+            {
+                if(kind.second == pattern.Kind)
+                {
+                    Result += kind.first + " ";
+                }
+            }
+            Result += pattern.Name;
+            Result += "\t\t\t\t\"";
+            Result += pattern.Pattern;
+            Result += "\"";
+            isFirst = false;
+        }
+        if(!Keywords.empty())
+        {
+            if(!isFirst)
+            {
+                Result += "\n";
+            }
+            Result += "\t\t\t\t%keyword";
+            for (auto& keyword : Keywords)
+            {
+                Result += " " + keyword;
+            }
+            isFirst = false;
+        }
+        if(!Operators.empty())
+        {
+            if(!isFirst)
+            {
+                Result += "\n";
+            }
+            Result += "\t\t\t\t%operator";
+            for (auto& op : Operators)
+            {
+                Result += " \"" + op + "\"";
+            }
+            isFirst = false;
+        }
+        for (size_t i = 0; i < BinaryOperators.size(); i++)
+        {
+            auto& op = BinaryOperators[i];
+            if(i == 0 || BinaryOperators[i - 1].Precedence != op.Precedence)
+            {
+                if(!isFirst)
+                {
+                    Result += "\n";
+                }
+                Result += "\t\t\t\t%";
+                for (auto& directive : GetPrecedenceDirectives())
+                {
+                    if(directive.second == op.Associativity)
+                    {
+                        Result += directive.first;
+                    }
+                }
+            }
+            Result += " \"" + op.Text + "\"";
+            isFirst = false;
+        }
         for (auto& lexer : RuleLexers)
         {
             if(!isFirst)
@@ -158,17 +344,45 @@ namespace ReParser::BNF
         }
         else
         {
-            SetError(RE_FORMAT("Unknown BNF State, failed to parse !! %s", GetLocation().c_str()));
+            Report(EDiagnosticCode::BNFUnknownState);
             return false;
         }
 
     }
 
+    void BNFParser::PostParserProcess(ICodeFile* file)
+    {
+        auto bnfFile = ReClassSystem::CastTo<BNFFile>(file);
+        if(!bnfFile)
+        {
+            return;
+        }
+        // the grammar is complete, binary expression rules climb the precedence table
+        if(!bnfFile->GetBinaryOperators().empty())
+        {
+            for (auto& rule : bnfFile->GetRuleLexers())
+            {
+                AST::PrecedenceNodeParser::TryApply(*rule.second, bnfFile->GetBinaryOperators());
+            }
+        }
+        // left-recursive rules grow from a seed instead of calling themselves forever
+        Re::Vector<AST::ASTNodeParser*> rules;
+        for (auto& rule : bnfFile->GetRuleLexers())
+        {
+            rules.push_back(Re::SharedPtrGet(rule.second));
+        }
+        AST::ResolveLeftRecursion(rules);
+    }
+
     bool BNFParser::ParseGlobal(BNFFile& file, const Token& token)
     {
+        if(token.Matches('%'))
+        {
+            return ParseDirective(file);
+        }
         if(!token.Matches('<'))
         {
-            SetError(RE_FORMAT("BNF line should start with '<' %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFExpectedRuleStart);
             return false;
         }
         UngetToken(token);
@@ -176,11 +390,127 @@ namespace ReParser::BNF
         return true;
     }
 
+    bool BNFParser::ParseDirective(BNFFile& file)
+    {
+        auto currentLine = GetInputLine();
+        auto directive = GetIdentifier(true);
+        if(directive && directive->Matches("token"))
+        {
+            return ParseTokenDirective(file, currentLine);
+        }
+        if(directive && directive->Matches("keyword"))
+        {
+            return ParseKeywordDirective(file, currentLine);
+        }
+        if(directive && directive->Matches("operator"))
+        {
+            return ParseOperatorDirective(file, currentLine);
+        }
+        if(directive)
+        {
+            auto it = GetPrecedenceDirectives().find(directive->GetTokenName());
+            if(it != GetPrecedenceDirectives().end())
+            {
+                return ParsePrecedenceDirective(file, currentLine, it->second);
+            }
+        }
+        Report(EDiagnosticCode::BNFUnknownDirective);
+        return false;
+    }
+
+    bool BNFParser::ParseTokenDirective(BNFFile& file, int64 currentLine)
+    {
+        // %token <kind> <Name> "<regex>"
+        auto kindToken = GetIdentifier(true);
+        auto nameToken = GetIdentifier(true);
+        auto patternToken = GetToken();
+        if(!kindToken || !nameToken || !patternToken || patternToken->GetConstType() != ETokenConstType::String || GetLine(patternToken->GetStartPos()) != currentLine)
+        {
+            Report(EDiagnosticCode::BNFInvalidTokenDeclaration);
+            return false;
+        }
+
+        const auto& Kinds = GetTokenPatternKinds();
+        auto kindIt = Kinds.find(kindToken->GetTokenName());
+        if(kindIt == Kinds.end())
+        {
+            Report(EDiagnosticCode::BNFUnknownTokenKind, { kindToken->GetTokenName() });
+            return false;
+        }
+
+        TokenPattern pattern;
+        pattern.Name = nameToken->GetTokenName();
+        pattern.Pattern = Re::String{patternToken->GetStringView()};
+        pattern.Kind = kindIt->second;
+        if(!file.AppendTokenPattern(pattern))
+        {
+            Report(EDiagnosticCode::BNFDuplicateToken, { pattern.Name });
+            return false;
+        }
+        return true;
+    }
+
+    bool BNFParser::ParseKeywordDirective(BNFFile& file, int64 currentLine)
+    {
+        // %keyword <word> <word> ... up to the end of the line
+        while(!IsEndOfLine(currentLine))
+        {
+            auto keywordToken = GetToken(true);
+            if(!keywordToken || keywordToken->GetTokenType() != ETokenType::Identifier)
+            {
+                Report(EDiagnosticCode::BNFInvalidKeyword);
+                return false;
+            }
+            file.AppendKeyword(keywordToken->GetTokenName());
+        }
+        return true;
+    }
+
+    bool BNFParser::ParseOperatorDirective(BNFFile& file, int64 currentLine)
+    {
+        // %operator "<op>" "<op>" ... up to the end of the line, quoted since the BNF lexer splits them
+        while(!IsEndOfLine(currentLine))
+        {
+            auto operatorToken = GetToken();
+            if(!operatorToken || operatorToken->GetConstType() != ETokenConstType::String || operatorToken->GetStringView().size() < 2)
+            {
+                Report(EDiagnosticCode::BNFInvalidOperator);
+                return false;
+            }
+            file.AppendOperator(Re::String{operatorToken->GetStringView()});
+        }
+        return true;
+    }
+
+    bool BNFParser::ParsePrecedenceDirective(BNFFile& file, int64 currentLine, AST::EOperatorAssociativity associativity)
+    {
+        // %left "<op>" "<op>" ... up to the end of the line, one precedence level
+        Re::Vector<Re::String> operators;
+        while(!IsEndOfLine(currentLine))
+        {
+            auto operatorToken = GetToken();
+            if(!operatorToken || operatorToken->GetConstType() != ETokenConstType::String || operatorToken->GetConstantValue().empty())
+            {
+                for (auto& directive : GetPrecedenceDirectives())
+                {
+                    if(directive.second == associativity)
+                    {
+                        Report(EDiagnosticCode::BNFInvalidPrecedence, { directive.first });
+                    }
+                }
+                return false;
+            }
+            operators.push_back(operatorToken->GetConstantValue());
+        }
+        file.AppendPrecedenceLevel(associativity, operators);
+        return true;
+    }
+
     bool BNFParser::ParseLeft(BNFFile& file, const Token& token)
     {
         if(!token.Matches('<'))
         {
-            SetError(RE_FORMAT("BNF line should start with '<'", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFExpectedRuleStart);
             return false;
         }
         Re::String lexerName;
@@ -197,14 +527,20 @@ namespace ReParser::BNF
 
         if(lexerName.empty())
         {
-            SetError(RE_FORMAT("BNF rule name cannot be null %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFEmptyRuleName);
+            return false;
+        }
+
+        if(file.FindTokenPattern(lexerName) >= 0)
+        {
+            Report(EDiagnosticCode::BNFRuleIsToken, { lexerName });
             return false;
         }
 
         Re::SharedPtr<AST::ASTNodeParser> rootParser;
         if(!file.AppendRule(lexerName, &rootParser))
         {
-            SetError(RE_FORMAT("BNF rule name %s repeated !! %s", lexerName.c_str(), GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFDuplicateRule, { lexerName });
             return false;
         }
 
@@ -216,10 +552,10 @@ namespace ReParser::BNF
 
     bool BNFParser::ParseRight(BNFFile& file, const Token& token)
     {
-        auto currentLine = InputLine;
+        auto currentLine = GetInputLine();
         if(!(token.Matches("::") && MatchSymbol("=")))
         {
-            SetError(RE_FORMAT("BNF rule must split by '::=' operator %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFExpectedDefine);
             return false;
         }
 
@@ -229,13 +565,13 @@ namespace ReParser::BNF
 
         if(IsEndOfLine(currentLine))
         {
-            SetError(RE_FORMAT("unexpect EOL %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::UnexpectedEndOfLine);
             return false;
         }
         auto nextToken = GetToken();
         if(!nextToken)
         {
-            SetError(RE_FORMAT("unexpect EOL %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::UnexpectedEndOfLine);
             return false;
         }
 
@@ -251,14 +587,14 @@ namespace ReParser::BNF
     {
         if(outParser && !outParser->GetSubRules().empty())
         {
-            SetError(RE_FORMAT("group node must be empty before parse !! %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFGroupNotEmpty);
             return false;
         }
 
         Re::SharedPtr<AST::GroupNodeParser> root = AST::CreateASTNode<AST::GroupNodeParser>();
         Re::SharedPtr<AST::GroupNodeParser> childGroupInOrGroup;
         Re::SharedPtr<AST::OrNodeParser> orGroup;
-        auto currentLine = InputLine;
+        auto currentLine = GetInputLine();
         auto currentToken = token;
         while(true)
         {
@@ -278,7 +614,7 @@ namespace ReParser::BNF
             }
             else
             {
-                SetError(RE_FORMAT("parse BNF rule failed %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::BNFRuleFailed);
                 return false;
             }
 
@@ -336,7 +672,7 @@ namespace ReParser::BNF
 
     bool BNFParser::ParseASTParser(BNFFile& file, const Token& token, Re::SharedPtr<AST::ASTNodeParser>* outParser)
     {
-        auto currentLine = InputLine;
+        auto currentLine = GetInputLine();
         Re::SharedPtr<AST::ASTNodeParser> result;
         if(token.Matches("<"))
         {
@@ -350,15 +686,20 @@ namespace ReParser::BNF
                 {
                     break;
                 }
-                if(currentLine != InputLine)
+                if(currentLine != GetInputLine())
                 {
-                    SetError(RE_FORMAT("unexpect EOL %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::UnexpectedEndOfLine);
                     return false;
                 }
                 lexerName += currentToken.GetTokenName();
             }
             auto it = file.GetRuleLexers().find(lexerName);
-            if(it == file.GetRuleLexers().end())
+            auto patternIndex = file.FindTokenPattern(lexerName);
+            if(patternIndex >= 0)
+            {
+                result = AST::CreateASTNode<AST::TerminalNodeParser>(lexerName, static_cast<uint16>(patternIndex + 1));
+            }
+            else if(it == file.GetRuleLexers().end())
             {
                 file.AppendRule(lexerName, &result);
             }
@@ -379,16 +720,16 @@ namespace ReParser::BNF
                 {
                     break;
                 }
-                if(currentLine != InputLine)
+                if(currentLine != GetInputLine())
                 {
-                    SetError(RE_FORMAT("unexpect EOL %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::UnexpectedEndOfLine);
                     return false;
                 }
                 auto nextToken = GetToken();
                 Re::SharedPtr<AST::ASTNodeParser> nextParser;
                 if(!ParseASTParser(file, *nextToken, &nextParser))
                 {
-                    SetError(RE_FORMAT("parse ASTParser failed !! %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::BNFNodeFailed);
                     return false;
                 }
                 group->AddRule(nextParser);
@@ -407,16 +748,16 @@ namespace ReParser::BNF
                 {
                     break;
                 }
-                if(currentLine != InputLine)
+                if(currentLine != GetInputLine())
                 {
-                    SetError(RE_FORMAT("unexpect EOL %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::UnexpectedEndOfLine);
                     return false;
                 }
                 auto nextToken = GetToken();
                 Re::SharedPtr<AST::ASTNodeParser> nextParser;
                 if(!ParseASTParser(file, *nextToken, &nextParser))
                 {
-                    SetError(RE_FORMAT("parse ASTParser failed !! %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::BNFNodeFailed);
                     return false;
                 }
                 group->AddRule(nextParser);
@@ -429,7 +770,7 @@ namespace ReParser::BNF
             auto group = AST::CreateASTNode<AST::GroupNodeParser>();
             if(!ParseASTParserGroup(file, token, group))
             {
-                SetError(RE_FORMAT("parse group node failed !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::BNFGroupFailed);
                 return false;
             }
             result = group;
@@ -441,12 +782,12 @@ namespace ReParser::BNF
         }
         else
         {
-            SetError(RE_FORMAT("invalid rule info %s", GetFileLocation(&file).c_str()));
+            Report(EDiagnosticCode::BNFInvalidRule);
             return false;
         }
 
         auto afterToken = GetToken(true);
-        if(currentLine == InputLine)
+        if(currentLine == GetInputLine())
         {
             if(afterToken)
             {
@@ -467,7 +808,7 @@ namespace ReParser::BNF
                 }
             }
         }
-        else
+        else if(afterToken)
         {
             UngetToken(afterToken);
         }
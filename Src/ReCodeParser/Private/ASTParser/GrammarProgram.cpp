@@ -0,0 +1,393 @@
+#include "GrammarProgram.h"
+#include "ASTParser/Nodes.h"
+#include "PackratMemo.h"
+
+namespace ReParser::AST
+{
+    Re::SharedPtr<GrammarProgram> GrammarProgram::Compile(ASTNodeParser& root, AtomTable& atoms)
+    {
+        auto result = Re::MakeShared<GrammarProgram>();
+        GrammarCompiler compiler(*result, atoms);
+        compiler.GetRuleIndex(root);
+        compiler.CompileRules();
+        return result;
+    }
+
+    Re::String GrammarProgram::ToString() const
+    {
+        static const char* OpNames[] = {
+            "MatchAtom", "MatchTerminal", "CallRule", "CallNative", "TestFirst", "Choice", "Commit",
+            "PartialCommit", "Jump", "Fail", "BeginGroup", "EndGroup", "Return" };
+        Re::String result;
+        for (size_t i = 0; i < Code.size(); i++)
+        {
+            for (auto& rule : Rules)
+            {
+                if (rule.Entry == static_cast<int32>(i))
+                {
+                    result += RE_FORMAT("%s:\n", rule.Parser->GetName());
+                }
+            }
+            result += RE_FORMAT("%4d %s %d\n", static_cast<int32>(i), OpNames[static_cast<size_t>(Code[i].Op)], Code[i].Arg);
+        }
+        return result;
+    }
+
+    void GrammarCompiler::EmitParser(ASTNodeParser& parser)
+    {
+        if (parser.IsDefinedParser())
+        {
+            Emit(EGrammarOp::CallRule, GetRuleIndex(parser));
+            return;
+        }
+        parser.Compile(*this);
+    }
+
+    void GrammarCompiler::EmitNative(ASTNodeParser& parser)
+    {
+        auto it = NativeIndices.find(&parser);
+        if (it == NativeIndices.end())
+        {
+            it = NativeIndices.insert(RE_MAKE_PAIR(&parser, static_cast<int32>(Program.Natives.size()))).first;
+            Program.Natives.push_back(&parser);
+        }
+        Emit(EGrammarOp::CallNative, it->second);
+    }
+
+    int32 GrammarCompiler::Emit(EGrammarOp op, int32 arg)
+    {
+        Program.Code.push_back({ op, arg });
+        return static_cast<int32>(Program.Code.size()) - 1;
+    }
+
+    int32 GrammarCompiler::AddFirstSet(const FirstSet& first)
+    {
+        Program.FirstSets.push_back(first);
+        return static_cast<int32>(Program.FirstSets.size()) - 1;
+    }
+
+    void GrammarCompiler::PatchToHere(int32 index)
+    {
+        Program.Code[static_cast<size_t>(index)].Arg = GetCodeSize();
+    }
+
+    int32 GrammarCompiler::GetRuleIndex(ASTNodeParser& parser)
+    {
+        auto it = RuleIndices.find(&parser);
+        if (it != RuleIndices.end())
+        {
+            return it->second;
+        }
+        const int32 index = static_cast<int32>(Program.Rules.size());
+        Program.Rules.push_back({ &parser, -1 });
+        RuleIndices.insert(RE_MAKE_PAIR(&parser, index));
+        PendingRules.push_back(index);
+        return index;
+    }
+
+    void GrammarCompiler::CompileRules()
+    {
+        while (!PendingRules.empty())
+        {
+            const int32 index = PendingRules.back();
+            PendingRules.pop_back();
+            auto& parser = *Program.Rules[static_cast<size_t>(index)].Parser;
+            Program.Rules[static_cast<size_t>(index)].Entry = GetCodeSize();
+            // the body itself, EmitParser would call the rule again
+            parser.Compile(*this);
+            Emit(EGrammarOp::Return);
+        }
+    }
+
+    bool GrammarVM::Run(const GrammarProgram& program, ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
+    {
+        Program = &program;
+        File = file;
+        Context = &context;
+        TokenNum = context.GetPreTokenNum();
+        context.UngetToken(token);
+        Pos = context.GetPreTokenCursor();
+        Backtracks.clear();
+        Values.clear();
+        Groups.clear();
+
+        const bool bParsed = CallRule(0);
+        if (bParsed)
+        {
+            *outNode = Values.empty() ? nullptr : Values.back();
+            context.SetPreTokenCursor(Pos);
+        }
+        Values.clear();
+        return bParsed;
+    }
+
+    ASTNodePtr GrammarVM::MatchToken(EGrammarOp op, int32 arg)
+    {
+        if (Pos >= TokenNum)
+        {
+            return nullptr;
+        }
+        const Token token = Context->GetPreToken(Pos);
+        if (op == EGrammarOp::MatchAtom)
+        {
+            return token.GetAtomId() == arg ? CreateASTNode<IdentifierNode>(token) : nullptr;
+        }
+        if (token.GetTerminalId() != arg)
+        {
+            return nullptr;
+        }
+        if (token.GetConstType() == ETokenConstType::String)
+        {
+            return CreateASTNode<StringNode>(token);
+        }
+        if (token.GetTokenType() == ETokenType::Const)
+        {
+            return CreateASTNode<NumNode>(token);
+        }
+        return CreateASTNode<IdentifierNode>(token);
+    }
+
+    bool GrammarVM::CallRule(int32 ruleIndex)
+    {
+        const ASTNodeParser& rule = *Program->GetRules()[static_cast<size_t>(ruleIndex)].Parser;
+        Context->RuleCallNum++;
+        const ELeftRecursion leftRecursion = rule.GetLeftRecursion();
+        PackratMemo* memo = leftRecursion != ELeftRecursion::Involved ? Re::SharedPtrGet(Context->Memo) : nullptr;
+        if (!memo && leftRecursion != ELeftRecursion::Leader)
+        {
+            return RunRule(ruleIndex);
+        }
+        const int32 startPos = Pos;
+        if (memo)
+        {
+            if (const PackratMemo::Entry* entry = memo->Find(rule, startPos))
+            {
+                if (!entry->bParsed)
+                {
+                    return false;
+                }
+                Pos = entry->EndPos;
+                if (entry->Node)
+                {
+                    Values.push_back(entry->Node);
+                }
+                return true;
+            }
+        }
+
+        const size_t valueNum = Values.size();
+        bool bParsed;
+        if (leftRecursion == ELeftRecursion::Leader)
+        {
+            bParsed = GrowRule(ruleIndex);
+            // another leader of the cycle growing here still changes what this one matches
+            if (!memo || Context->IsGrowingAt(startPos))
+            {
+                return bParsed;
+            }
+        }
+        else
+        {
+            bParsed = RunRule(ruleIndex);
+        }
+        if (!bParsed)
+        {
+            memo->Store(rule, startPos, false, startPos, nullptr);
+        }
+        else if (Values.size() <= valueNum + 1)
+        {
+            // a rule leaving several nodes cannot be replayed from one entry
+            memo->Store(rule, startPos, true, Pos, Values.size() > valueNum ? Values.back() : nullptr);
+        }
+        return bParsed;
+    }
+
+    bool GrammarVM::GrowRule(int32 ruleIndex)
+    {
+        const ASTNodeParser& rule = *Program->GetRules()[static_cast<size_t>(ruleIndex)].Parser;
+        const int32 startPos = Pos;
+        if (const LeftRecursionSeed* seed = Context->FindSeed(rule, startPos))
+        {
+            // the left-recursive call, reads the result of the last pass
+            if (!seed->bParsed)
+            {
+                return false;
+            }
+            Pos = seed->EndPos;
+            if (seed->Node)
+            {
+                Values.push_back(seed->Node);
+            }
+            return true;
+        }
+
+        auto& seeds = Context->Seeds;
+        seeds.push_back({ &rule, startPos, false, startPos, nullptr });
+        const size_t seedIndex = seeds.size() - 1;
+        const size_t valueNum = Values.size();
+        while (RunRule(ruleIndex))
+        {
+            RE_ASSERT(Values.size() <= valueNum + 1);
+            ASTNodePtr node = Values.size() > valueNum ? Values.back() : nullptr;
+            Values.resize(valueNum);
+            LeftRecursionSeed& seed = seeds[seedIndex];
+            if (seed.bParsed && Pos <= seed.EndPos)
+            {
+                break;
+            }
+            seed.bParsed = true;
+            seed.EndPos = Pos;
+            seed.Node = std::move(node);
+            Pos = startPos;
+        }
+
+        LeftRecursionSeed seed = std::move(seeds[seedIndex]);
+        seeds.pop_back();
+        if (!seed.bParsed)
+        {
+            Pos = startPos;
+            return false;
+        }
+        Pos = seed.EndPos;
+        if (seed.Node)
+        {
+            Values.push_back(std::move(seed.Node));
+        }
+        return true;
+    }
+
+    bool GrammarVM::RunRule(int32 ruleIndex)
+    {
+        const auto& code = Program->GetCode();
+        const size_t backtrackBase = Backtracks.size();
+        const int32 valueBase = static_cast<int32>(Values.size());
+        const int32 groupBase = static_cast<int32>(Groups.size());
+        const int32 startPos = Pos;
+        int32 pc = Program->GetRules()[static_cast<size_t>(ruleIndex)].Entry;
+        while (true)
+        {
+            const GrammarInstruction& instruction = code[static_cast<size_t>(pc)];
+            bool bFailed = false;
+            switch (instruction.Op)
+            {
+            case EGrammarOp::MatchAtom:
+            case EGrammarOp::MatchTerminal:
+                {
+                    ASTNodePtr node = MatchToken(instruction.Op, instruction.Arg);
+                    if (node)
+                    {
+                        Values.push_back(std::move(node));
+                        Pos++;
+                        pc++;
+                    }
+                    else
+                    {
+                        bFailed = true;
+                    }
+                }
+                break;
+            case EGrammarOp::CallRule:
+                bFailed = !CallRule(instruction.Arg);
+                pc++;
+                break;
+            case EGrammarOp::CallNative:
+                {
+                    // natives read the tokens through the parser cursor
+                    const Token token = Pos < TokenNum ? Context->GetPreToken(Pos) : Context->GetEndToken();
+                    Context->SetPreTokenCursor(Pos);
+                    Context->GetToken();
+                    ASTNodePtr node;
+                    if (Program->GetNative(instruction.Arg).Parse(File, *Context, token, &node))
+                    {
+                        Pos = Context->GetPreTokenCursor();
+                        if (node)
+                        {
+                            Values.push_back(std::move(node));
+                        }
+                        pc++;
+                    }
+                    else
+                    {
+                        bFailed = true;
+                    }
+                }
+                break;
+            case EGrammarOp::TestFirst:
+                {
+                    const Token token = Pos < TokenNum ? Context->GetPreToken(Pos) : Context->GetEndToken();
+                    pc += Program->GetFirstSet(instruction.Arg).Contains(token) ? 2 : 1;
+                }
+                break;
+            case EGrammarOp::Choice:
+                Backtracks.push_back({ instruction.Arg, Pos, static_cast<int32>(Values.size()), static_cast<int32>(Groups.size()) });
+                pc++;
+                break;
+            case EGrammarOp::Commit:
+                Backtracks.pop_back();
+                pc = instruction.Arg;
+                break;
+            case EGrammarOp::PartialCommit:
+                {
+                    Backtrack& entry = Backtracks.back();
+                    if (entry.Pos == Pos)
+                    {
+                        Backtracks.pop_back();
+                        pc++;
+                    }
+                    else
+                    {
+                        entry.Pos = Pos;
+                        entry.ValueNum = static_cast<int32>(Values.size());
+                        entry.GroupNum = static_cast<int32>(Groups.size());
+                        pc = instruction.Arg;
+                    }
+                }
+                break;
+            case EGrammarOp::Jump:
+                pc = instruction.Arg;
+                break;
+            case EGrammarOp::Fail:
+                bFailed = true;
+                break;
+            case EGrammarOp::BeginGroup:
+                Groups.push_back(static_cast<int32>(Values.size()));
+                pc++;
+                break;
+            case EGrammarOp::EndGroup:
+                {
+                    const size_t first = static_cast<size_t>(Groups.back());
+                    Groups.pop_back();
+                    auto group = CreateASTNode<GroupNode>();
+                    for (size_t i = first; i < Values.size(); i++)
+                    {
+                        group->AppendNode(Values[i]);
+                    }
+                    Values.resize(first);
+                    Values.push_back(std::move(group));
+                    pc++;
+                }
+                break;
+            case EGrammarOp::Return:
+                RE_ASSERT(Backtracks.size() == backtrackBase);
+                return true;
+            }
+
+            if (bFailed)
+            {
+                if (Backtracks.size() == backtrackBase)
+                {
+                    Pos = startPos;
+                    Values.resize(static_cast<size_t>(valueBase));
+                    Groups.resize(static_cast<size_t>(groupBase));
+                    return false;
+                }
+                const Backtrack entry = Backtracks.back();
+                Backtracks.pop_back();
+                pc = entry.Pc;
+                Pos = entry.Pos;
+                Values.resize(static_cast<size_t>(entry.ValueNum));
+                Groups.resize(static_cast<size_t>(entry.GroupNum));
+            }
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "ASTParser.h"
+
+namespace ReParser::AST
+{
+    enum class EGrammarOp : uint8
+    {
+        // match the current token and push its node, fail otherwise
+        MatchAtom,
+        MatchTerminal,
+        // run rule Arg and push its node
+        CallRule,
+        // run the Parse of native parser Arg, for parsers without bytecode
+        CallNative,
+        // skip the next instruction when the current token is in first set Arg
+        TestFirst,
+        // push a backtrack entry resuming at Arg on failure
+        Choice,
+        // drop the backtrack entry and jump to Arg
+        Commit,
+        // end of a loop body, move the backtrack entry to the current position and jump back to Arg,
+        // a body that matched nothing leaves the loop instead
+        PartialCommit,
+        Jump,
+        Fail,
+        // collect the nodes pushed between them into a GroupNode
+        BeginGroup,
+        EndGroup,
+        Return,
+    };
+
+    struct GrammarInstruction
+    {
+        EGrammarOp Op = EGrammarOp::Fail;
+        int32 Arg = 0;
+    };
+
+    /** A grammar lowered to a flat instruction array, every named rule is a function of it. */
+    class RECODEPARSER_API GrammarProgram
+    {
+    public:
+        struct Rule
+        {
+            ASTNodeParser* Parser = nullptr;
+            int32 Entry = 0;
+        };
+
+        /** Compiles root and every rule it reaches, literals are interned into atoms. */
+        static Re::SharedPtr<GrammarProgram> Compile(ASTNodeParser& root, AtomTable& atoms);
+
+        const Re::Vector<GrammarInstruction>& GetCode() const { return Code; }
+        const Re::Vector<Rule>& GetRules() const { return Rules; }
+        ASTNodeParser& GetNative(int32 index) const { return *Natives[static_cast<size_t>(index)]; }
+        const FirstSet& GetFirstSet(int32 index) const { return FirstSets[static_cast<size_t>(index)]; }
+
+        Re::String ToString() const;
+
+    private:
+        friend class GrammarCompiler;
+
+        Re::Vector<GrammarInstruction> Code;
+        // rule 0 is the root
+        Re::Vector<Rule> Rules;
+        Re::Vector<ASTNodeParser*> Natives;
+        Re::Vector<FirstSet> FirstSets;
+    };
+
+    /** Emits the code of the parser tree, ASTNodeParser::Compile calls back into it. */
+    class RECODEPARSER_API GrammarCompiler
+    {
+    public:
+        GrammarCompiler(GrammarProgram& program, AtomTable& atoms)
+            : Program(program)
+            , Atoms(atoms)
+        {
+        }
+
+        /** Emits the code matching parser, a named rule becomes a call of its own code. */
+        void EmitParser(ASTNodeParser& parser);
+        void EmitNative(ASTNodeParser& parser);
+
+        /** @return index of the instruction. */
+        int32 Emit(EGrammarOp op, int32 arg = 0);
+        /** Sets the argument of the instruction at index to the next instruction emitted. */
+        void PatchToHere(int32 index);
+        int32 GetCodeSize() const { return static_cast<int32>(Program.Code.size()); }
+
+        int32 InternAtom(const Re::String& text) { return Atoms.Intern(text); }
+        /** @return index of a copy of first for TestFirst. */
+        int32 AddFirstSet(const FirstSet& first);
+
+        int32 GetRuleIndex(ASTNodeParser& parser);
+        /** Compiles the rules found so far and those they reach. */
+        void CompileRules();
+
+    private:
+        GrammarProgram& Program;
+        AtomTable& Atoms;
+        Re::Map<const ASTNodeParser*, int32> RuleIndices;
+        Re::Map<const ASTNodeParser*, int32> NativeIndices;
+        // rules found but not compiled yet
+        Re::Vector<int32> PendingRules;
+    };
+
+    /** Runs a GrammarProgram over the pre-tokenized input of a parser. */
+    class RECODEPARSER_API GrammarVM
+    {
+    public:
+        /** Parses from token like ASTNodeParser::Parse does with the root rule. */
+        bool Run(const GrammarProgram& program, ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode);
+
+    private:
+        struct Backtrack
+        {
+            int32 Pc = 0;
+            int32 Pos = 0;
+            int32 ValueNum = 0;
+            int32 GroupNum = 0;
+        };
+
+        /** Runs the rule, through the packrat memo of the parser when it has one. */
+        bool CallRule(int32 ruleIndex);
+        /** Runs a left-recursive leader until its match stops growing, see ASTParser::ParseRule. */
+        bool GrowRule(int32 ruleIndex);
+        bool RunRule(int32 ruleIndex);
+        ASTNodePtr MatchToken(EGrammarOp op, int32 arg);
+
+        const GrammarProgram* Program = nullptr;
+        ICodeFile* File = nullptr;
+        ASTParser* Context = nullptr;
+        // index of the current token in the pre-tokenized input
+        int32 Pos = 0;
+        int32 TokenNum = 0;
+        Re::Vector<Backtrack> Backtracks;
+        // nodes of the rules being run
+        Re::Vector<ASTNodePtr> Values;
+        // value count at each open BeginGroup
+        Re::Vector<int32> Groups;
+    };
+}
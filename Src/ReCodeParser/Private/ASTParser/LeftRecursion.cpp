@@ -0,0 +1,261 @@
+#include "LeftRecursion.h"
+#include <algorithm>
+#include "ReClassMisc.h"
+#include "Parsers.h"
+
+namespace ReParser::AST
+{
+    namespace
+    {
+        // named rules and the rules each may call before consuming a token
+        class LeftCallGraph
+        {
+        public:
+            explicit LeftCallGraph(const Re::Vector<ASTNodeParser*>& rules)
+                : Rules(rules)
+                , Calls(rules.size())
+            {
+                for (size_t i = 0; i < Rules.size(); i++)
+                {
+                    Indices[Rules[i]] = static_cast<int32>(i);
+                }
+                for (size_t i = 0; i < Rules.size(); i++)
+                {
+                    Re::Vector<ASTNodeParser*> calls;
+                    Rules[i]->CollectLeftRules(calls);
+                    for (auto call : calls)
+                    {
+                        auto it = Indices.find(call);
+                        if (it != Indices.end())
+                        {
+                            Calls[i].push_back(it->second);
+                        }
+                    }
+                }
+            }
+
+            int32 Num() const { return static_cast<int32>(Rules.size()); }
+            ASTNodeParser& GetRule(int32 index) const { return *Rules[static_cast<size_t>(index)]; }
+            const Re::Vector<int32>& GetCalls(int32 index) const { return Calls[static_cast<size_t>(index)]; }
+
+            /** Strongly connected components, Tarjan's algorithm. */
+            Re::Vector<Re::Vector<int32>> FindComponents()
+            {
+                Order.assign(Rules.size(), -1);
+                LowLink.assign(Rules.size(), 0);
+                bOnStack.assign(Rules.size(), false);
+                Components.clear();
+                for (int32 i = 0; i < Num(); i++)
+                {
+                    if (Order[static_cast<size_t>(i)] < 0)
+                    {
+                        Visit(i);
+                    }
+                }
+                return std::move(Components);
+            }
+
+            /** Whether the rules of component not in excluded still call each other in a cycle. */
+            bool HasCycle(const Re::Vector<int32>& component, const Re::Vector<bool>& excluded) const
+            {
+                // 0 unvisited, 1 on the path, 2 done
+                Re::Vector<uint8> states(Rules.size(), 0);
+                Re::Func<bool(int32)> visit = [&](int32 index)
+                {
+                    states[static_cast<size_t>(index)] = 1;
+                    for (int32 call : GetCalls(index))
+                    {
+                        if (excluded[static_cast<size_t>(call)] || !Contains(component, call))
+                        {
+                            continue;
+                        }
+                        if (states[static_cast<size_t>(call)] == 1 || (states[static_cast<size_t>(call)] == 0 && visit(call)))
+                        {
+                            return true;
+                        }
+                    }
+                    states[static_cast<size_t>(index)] = 2;
+                    return false;
+                };
+                for (int32 index : component)
+                {
+                    if (!excluded[static_cast<size_t>(index)] && states[static_cast<size_t>(index)] == 0 && visit(index))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static bool Contains(const Re::Vector<int32>& indices, int32 index)
+            {
+                return std::find(indices.begin(), indices.end(), index) != indices.end();
+            }
+
+        private:
+            void Visit(int32 index)
+            {
+                const size_t i = static_cast<size_t>(index);
+                Order[i] = LowLink[i] = NextOrder++;
+                Stack.push_back(index);
+                bOnStack[i] = true;
+                for (int32 call : Calls[i])
+                {
+                    const size_t c = static_cast<size_t>(call);
+                    if (Order[c] < 0)
+                    {
+                        Visit(call);
+                        LowLink[i] = std::min(LowLink[i], LowLink[c]);
+                    }
+                    else if (bOnStack[c])
+                    {
+                        LowLink[i] = std::min(LowLink[i], Order[c]);
+                    }
+                }
+                if (LowLink[i] != Order[i])
+                {
+                    return;
+                }
+                Re::Vector<int32> component;
+                int32 member;
+                do
+                {
+                    member = Stack.back();
+                    Stack.pop_back();
+                    bOnStack[static_cast<size_t>(member)] = false;
+                    component.push_back(member);
+                } while (member != index);
+                Components.push_back(std::move(component));
+            }
+
+            const Re::Vector<ASTNodeParser*>& Rules;
+            Re::Map<const ASTNodeParser*, int32> Indices;
+            Re::Vector<Re::Vector<int32>> Calls;
+
+            Re::Vector<int32> Order;
+            Re::Vector<int32> LowLink;
+            Re::Vector<bool> bOnStack;
+            Re::Vector<int32> Stack;
+            Re::Vector<Re::Vector<int32>> Components;
+            int32 NextOrder = 0;
+        };
+
+        // rules may match nothing through each other, repeat until nothing changes
+        void ResolveNullable(const Re::Vector<ASTNodeParser*>& rules)
+        {
+            for (auto rule : rules)
+            {
+                rule->SetNullable(false);
+            }
+            bool bChanged = true;
+            while (bChanged)
+            {
+                bChanged = false;
+                for (auto rule : rules)
+                {
+                    Re::Vector<ASTNodeParser*> calls;
+                    if (!rule->IsNullable() && rule->CollectLeftRules(calls))
+                    {
+                        rule->SetNullable(true);
+                        bChanged = true;
+                    }
+                }
+            }
+        }
+
+        // the rule calling most others of the cycle breaks most of it, a rule calling itself has to lead anyway
+        int32 PickLeader(const LeftCallGraph& graph, const Re::Vector<int32>& component, const Re::Vector<bool>& bLeaders)
+        {
+            int32 best = -1;
+            int32 bestScore = -1;
+            for (int32 index : component)
+            {
+                if (bLeaders[static_cast<size_t>(index)])
+                {
+                    continue;
+                }
+                int32 score = 0;
+                for (int32 caller : component)
+                {
+                    if (!bLeaders[static_cast<size_t>(caller)] && LeftCallGraph::Contains(graph.GetCalls(caller), index))
+                    {
+                        score += caller == index ? static_cast<int32>(component.size()) : 1;
+                    }
+                }
+                if (score > bestScore)
+                {
+                    best = index;
+                    bestScore = score;
+                }
+            }
+            return best;
+        }
+
+        void PreferGrowingAlternatives(const LeftCallGraph& graph, ASTNodeParser& leader, const Re::Vector<int32>& component)
+        {
+            // rules of a BNF file are a group holding the alternatives
+            auto group = ReClassSystem::CastTo<GroupNodeParser>(&leader);
+            if (!group || group->GetSubRules().size() != 1)
+            {
+                return;
+            }
+            auto& body = group->GetSubRules()[0];
+            auto alternatives = body && !body->IsDefinedParser() ? ReClassSystem::CastTo<OrNodeParser>(Re::SharedPtrGet(body)) : nullptr;
+            if (!alternatives)
+            {
+                return;
+            }
+            alternatives->PreferAlternatives([&](const ASTNodeParser& alternative)
+            {
+                Re::Vector<ASTNodeParser*> calls;
+                if (alternative.IsDefinedParser())
+                {
+                    calls.push_back(const_cast<ASTNodeParser*>(&alternative));
+                }
+                else
+                {
+                    alternative.CollectLeftRules(calls);
+                }
+                for (int32 index : component)
+                {
+                    if (std::find(calls.begin(), calls.end(), &graph.GetRule(index)) != calls.end())
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        }
+    }
+
+    void ResolveLeftRecursion(const Re::Vector<ASTNodeParser*>& rules)
+    {
+        ResolveNullable(rules);
+
+        LeftCallGraph graph(rules);
+        Re::Vector<bool> bLeaders(rules.size(), false);
+        for (auto rule : rules)
+        {
+            rule->SetLeftRecursion(ELeftRecursion::None);
+        }
+        for (const auto& component : graph.FindComponents())
+        {
+            const int32 first = component[0];
+            if (component.size() == 1 && !LeftCallGraph::Contains(graph.GetCalls(first), first))
+            {
+                continue;
+            }
+            for (int32 index : component)
+            {
+                graph.GetRule(index).SetLeftRecursion(ELeftRecursion::Involved);
+            }
+            while (graph.HasCycle(component, bLeaders))
+            {
+                const int32 leader = PickLeader(graph, component, bLeaders);
+                bLeaders[static_cast<size_t>(leader)] = true;
+                graph.GetRule(leader).SetLeftRecursion(ELeftRecursion::Leader);
+                PreferGrowingAlternatives(graph, graph.GetRule(leader), component);
+            }
+        }
+    }
+}
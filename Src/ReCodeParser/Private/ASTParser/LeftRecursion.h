@@ -0,0 +1,13 @@
+#pragma once
+#include "ASTParser.h"
+
+namespace ReParser::AST
+{
+    /**
+     * Marks the named rules that may call themselves before consuming a token, directly or through other rules,
+     * called once the grammar is complete. Every left-recursive cycle gets leaders, rules growing their result from
+     * a seed and enough of them to break every cycle, the other rules on the cycle are Involved. A leader tries the
+     * alternatives starting with a rule of its cycle first, those are the ones growing the seed.
+     */
+    RECODEPARSER_API void ResolveLeftRecursion(const Re::Vector<ASTNodeParser*>& rules);
+}
@@ -0,0 +1,65 @@
+#include "PackratMemo.h"
+
+namespace ReParser::AST
+{
+    const PackratMemo::Entry* PackratMemo::Find(const ASTNodeParser& rule, int32 pos)
+    {
+        if(pos >= 0 && static_cast<size_t>(pos) < Positions.size())
+        {
+            for (Slot& slot : Positions[static_cast<size_t>(pos)])
+            {
+                if(slot.Value.Rule == &rule)
+                {
+                    HitNum++;
+                    Uses.splice(Uses.begin(), Uses, slot.LastUse);
+                    return &slot.Value;
+                }
+            }
+        }
+        MissNum++;
+        return nullptr;
+    }
+
+    void PackratMemo::Store(const ASTNodeParser& rule, int32 pos, bool bParsed, int32 endPos, const ASTNodePtr& node)
+    {
+        if(static_cast<size_t>(pos) >= Positions.size())
+        {
+            Positions.resize(static_cast<size_t>(pos) + 1);
+        }
+        Uses.push_front({ pos, &rule });
+        Positions[static_cast<size_t>(pos)].push_back({ { &rule, bParsed, endPos, node }, Uses.begin() });
+        if(++EntryNum > MaxEntries)
+        {
+            Evict();
+        }
+    }
+
+    void PackratMemo::Reset()
+    {
+        Positions.clear();
+        Uses.clear();
+        EntryNum = 0;
+    }
+
+    void PackratMemo::Evict()
+    {
+        // the entry just stored is the front of Uses and MaxEntries is at least 1
+        while(EntryNum > MaxEntries)
+        {
+            const Use oldest = Uses.back();
+            Uses.pop_back();
+            auto& slots = Positions[static_cast<size_t>(oldest.Pos)];
+            for (size_t i = 0; i < slots.size(); i++)
+            {
+                if(slots[i].Value.Rule == oldest.Rule)
+                {
+                    slots[i] = std::move(slots.back());
+                    slots.pop_back();
+                    break;
+                }
+            }
+            EntryNum--;
+            EvictedNum++;
+        }
+    }
+}
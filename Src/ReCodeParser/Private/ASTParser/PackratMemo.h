@@ -0,0 +1,66 @@
+#pragma once
+#include "ASTParser.h"
+
+namespace ReParser::AST
+{
+    /**
+     * Results of named rules keyed by (rule, token index), a rule backtracked into at a position it already ran at
+     * costs a lookup instead of a parse. Holds at most MaxEntries results, past that the least recently used goes
+     * first: the outer rules store last and their choice points backtrack last, so they are the ones kept.
+     */
+    class RECODEPARSER_API PackratMemo
+    {
+    public:
+        struct Entry
+        {
+            const ASTNodeParser* Rule = nullptr;
+            bool bParsed = false;
+            // token index behind the match
+            int32 EndPos = 0;
+            ASTNodePtr Node;
+        };
+
+        explicit PackratMemo(int32 maxEntries)
+            : MaxEntries(maxEntries > 0 ? maxEntries : 1)
+        {
+        }
+
+        /** @return the result of rule at pos, nullptr when it is not known. */
+        const Entry* Find(const ASTNodeParser& rule, int32 pos);
+        /** Adds the result of rule at pos, it is never the entry evicted to make room. */
+        void Store(const ASTNodeParser& rule, int32 pos, bool bParsed, int32 endPos, const ASTNodePtr& node);
+        /** Drops every entry, token indices change between declarations. */
+        void Reset();
+
+        int32 GetEntryNum() const { return EntryNum; }
+        int32 GetMaxEntries() const { return MaxEntries; }
+        int32 GetHitNum() const { return HitNum; }
+        int32 GetMissNum() const { return MissNum; }
+        int32 GetEvictedNum() const { return EvictedNum; }
+
+    private:
+        struct Use
+        {
+            int32 Pos = 0;
+            const ASTNodeParser* Rule = nullptr;
+        };
+        struct Slot
+        {
+            Entry Value;
+            // where the entry is in Uses
+            Re::List<Use>::iterator LastUse;
+        };
+
+        void Evict();
+
+        // entries by token index, the token indices of a declaration are dense
+        Re::Vector<Re::Vector<Slot>> Positions;
+        // most recently used first
+        Re::List<Use> Uses;
+        int32 EntryNum = 0;
+        int32 MaxEntries = 0;
+        int32 HitNum = 0;
+        int32 MissNum = 0;
+        int32 EvictedNum = 0;
+    };
+}
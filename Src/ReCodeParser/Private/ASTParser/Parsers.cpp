@@ -1,13 +1,61 @@
 #include "Parsers.h"
+#include <algorithm>
+#include "ReClassMisc.h"
 #include "ASTParser/Nodes.h"
+#include "GrammarProgram.h"
 
 namespace ReParser::AST
 {
+    // a named rule is only called, whether it may match nothing is known once the grammar is analyzed
+    static bool CollectSubRule(const Re::SharedPtr<ASTNodeParser>& subRule, Re::Vector<ASTNodeParser*>& outRules)
+    {
+        if(!subRule)
+        {
+            return false;
+        }
+        if(subRule->IsDefinedParser())
+        {
+            outRules.push_back(Re::SharedPtrGet(subRule));
+            return subRule->IsNullable();
+        }
+        return subRule->CollectLeftRules(outRules);
+    }
+
+    // named rules are updated by the caller of UpdateFirst, so a cycle of rules stays one pass
+    static bool UpdateSubFirst(const Re::SharedPtr<ASTNodeParser>& subRule)
+    {
+        return subRule && !subRule->IsDefinedParser() && subRule->UpdateFirst();
+    }
+
+    static void BuildSubDispatch(const Re::SharedPtr<ASTNodeParser>& subRule)
+    {
+        if(subRule && !subRule->IsDefinedParser())
+        {
+            subRule->BuildDispatch();
+        }
+    }
+
+    template <typename KeyType>
+    static const Re::Vector<int32>* FindAlternatives(const Re::Map<KeyType, Re::Vector<int32>>& alternatives, KeyType key)
+    {
+        if(key == 0)
+        {
+            return nullptr;
+        }
+        auto it = alternatives.find(key);
+        return it != alternatives.end() ? &it->second : nullptr;
+    }
+
+    static int64 GetDispatchKey(int32 atom, int32 terminal)
+    {
+        return (static_cast<int64>(atom) << 32) | static_cast<uint32>(terminal);
+    }
+
     DEFINE_DERIVED_CLASS_WITHOUT_NEW(RequiredIdentifierNodeParser, ASTNodeParser)
     // `xxx` in BNF
     bool RequiredIdentifierNodeParser::Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
     {
-        if(token.Matches(TokenName.c_str()))
+        if(Atom != 0 ? token.GetAtomId() == Atom : token.Matches(TokenName.c_str()))
         {
             *outNode = CreateASTNode<IdentifierNode>(token);
             return true;
@@ -15,6 +63,11 @@ namespace ReParser::AST
         return false;
     }
 
+    void RequiredIdentifierNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        compiler.Emit(EGrammarOp::MatchAtom, compiler.InternAtom(TokenName));
+    }
+
     Re::String RequiredIdentifierNodeParser::ToString() const
     {
         Re::String Result;
@@ -24,28 +77,268 @@ namespace ReParser::AST
         return Result;
     }
 
+    DEFINE_DERIVED_CLASS_WITHOUT_NEW(TerminalNodeParser, ASTNodeParser)
+    // <Name> of a %token in BNF
+    bool TerminalNodeParser::Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
+    {
+        if(token.GetTerminalId() != TerminalId)
+        {
+            return false;
+        }
+        if(token.GetConstType() == ETokenConstType::String)
+        {
+            *outNode = CreateASTNode<StringNode>(token);
+        }
+        else if(token.GetTokenType() == ETokenType::Const)
+        {
+            *outNode = CreateASTNode<NumNode>(token);
+        }
+        else
+        {
+            *outNode = CreateASTNode<IdentifierNode>(token);
+        }
+        return true;
+    }
+
+    void TerminalNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        compiler.Emit(EGrammarOp::MatchTerminal, TerminalId);
+    }
+
+    Re::String TerminalNodeParser::ToString() const
+    {
+        Re::String Result;
+        Result += "<";
+        Result += TokenName;
+        Result += ">";
+        return Result;
+    }
+
     DEFINE_DERIVED_CLASS_WITHOUT_NEW(OrNodeParser, ASTNodeParser)
     // a | b in BNF
     bool OrNodeParser::Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
     {
-        for (auto& subRule : SubRules)
+        if(!bDispatch)
         {
-            auto rule = Re::SharedPtrGet(subRule);
-            if(!rule)
+            for (auto& subRule : Alternatives)
             {
-                continue;
+                if(subRule && TryAlternative(*subRule, file, context, token, outNode))
+                {
+                    return true;
+                }
             }
-            if(rule->Parse(file, context, token, outNode))
+            return false;
+        }
+
+        const int32 atom = token.GetAtomId();
+        const int32 terminal = token.GetTerminalId();
+        const Re::Vector<int32>* candidates = nullptr;
+        if(atom != 0 && terminal != 0)
+        {
+            candidates = FindAlternatives(AtomTerminalAlternatives, GetDispatchKey(atom, terminal));
+        }
+        if(!candidates)
+        {
+            candidates = FindAlternatives(AtomAlternatives, atom);
+        }
+        if(!candidates)
+        {
+            candidates = FindAlternatives(TerminalAlternatives, terminal);
+        }
+        if(!candidates)
+        {
+            candidates = &AnyAlternatives;
+        }
+        for (int32 index : *candidates)
+        {
+            if(TryAlternative(*Alternatives[static_cast<size_t>(index)], file, context, token, outNode))
             {
-                TRACE_AST_PARSE_F("%s try parse %s by %s succ", GetName(), token.GetTokenName().c_str(),  rule->ToString().c_str());
                 return true;
             }
-            TRACE_AST_PARSE_F("%s try parse %s by %s failed", GetName(), token.GetTokenName().c_str(), rule->ToString().c_str());
-            context.ResetToToken(token);
         }
         return false;
     }
 
+    bool OrNodeParser::TryAlternative(ASTNodeParser& rule, ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
+    {
+        if(context.ParseRule(rule, file, token, outNode))
+        {
+            TRACE_AST_PARSE_F("%s try parse %s by %s succ", GetName(), token.GetTokenName().c_str(),  rule.ToString().c_str());
+            return true;
+        }
+        TRACE_AST_PARSE_F("%s try parse %s by %s failed", GetName(), token.GetTokenName().c_str(), rule.ToString().c_str());
+        outNode->reset();
+        context.ResetToToken(token);
+        return false;
+    }
+
+    void OrNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        Re::Vector<ASTNodeParser*> rules;
+        for (auto& subRule : Alternatives)
+        {
+            if(subRule)
+            {
+                rules.push_back(Re::SharedPtrGet(subRule));
+            }
+        }
+        if(rules.empty())
+        {
+            compiler.Emit(EGrammarOp::Fail);
+            return;
+        }
+        // Choice Next, <rule>, Commit End for every rule but the last one, once the first sets are known
+        // a rule that cannot start with the current token is skipped by TestFirst Set, Jump Next before it
+        Re::Vector<int32> commits;
+        for (size_t i = 0; i < rules.size(); i++)
+        {
+            const bool bLast = i + 1 == rules.size();
+            int32 skip = -1;
+            if(bDispatch && !rules[i]->GetFirst().bAny && !rules[i]->IsNullable())
+            {
+                compiler.Emit(EGrammarOp::TestFirst, compiler.AddFirstSet(rules[i]->GetFirst()));
+                skip = compiler.Emit(EGrammarOp::Jump);
+            }
+            const int32 choice = bLast ? -1 : compiler.Emit(EGrammarOp::Choice);
+            compiler.EmitParser(*rules[i]);
+            if(!bLast)
+            {
+                commits.push_back(compiler.Emit(EGrammarOp::Commit));
+                compiler.PatchToHere(choice);
+            }
+            else if(skip >= 0)
+            {
+                commits.push_back(compiler.Emit(EGrammarOp::Jump));
+            }
+            if(skip >= 0)
+            {
+                compiler.PatchToHere(skip);
+            }
+        }
+        if(commits.size() == rules.size())
+        {
+            // the last rule was skipped
+            compiler.Emit(EGrammarOp::Fail);
+        }
+        for (auto commit : commits)
+        {
+            compiler.PatchToHere(commit);
+        }
+    }
+
+    void OrNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        for (auto& subRule : SubRules)
+        {
+            // named rules resolve on their own, rules may refer to each other in cycles
+            if(subRule && !subRule->IsDefinedParser())
+            {
+                subRule->ResolveAtoms(atoms);
+            }
+        }
+    }
+
+    void OrNodeParser::PreferAlternatives(const Re::Func<bool(const ASTNodeParser& alternative)>& bFirst)
+    {
+        std::stable_partition(Alternatives.begin(), Alternatives.end(), [&](const Re::SharedPtr<ASTNodeParser>& alternative)
+        {
+            return alternative && bFirst(*alternative);
+        });
+        // the dispatch lists hold indices of the old order
+        bDispatch = false;
+    }
+
+    bool OrNodeParser::UpdateFirst()
+    {
+        bool bGrew = false;
+        for (auto& subRule : SubRules)
+        {
+            if(!subRule)
+            {
+                continue;
+            }
+            bGrew |= UpdateSubFirst(subRule);
+            bGrew |= MergeFirst(*subRule);
+            if(subRule->IsNullable())
+            {
+                bGrew |= MarkNullable();
+            }
+        }
+        return bGrew;
+    }
+
+    void OrNodeParser::BuildDispatch()
+    {
+        AtomAlternatives.clear();
+        TerminalAlternatives.clear();
+        AtomTerminalAlternatives.clear();
+        AnyAlternatives.clear();
+        for (size_t i = 0; i < Alternatives.size(); i++)
+        {
+            auto& alternative = Alternatives[i];
+            if(!alternative)
+            {
+                continue;
+            }
+            BuildSubDispatch(alternative);
+            const int32 index = static_cast<int32>(i);
+            const FirstSet& first = alternative->GetFirst();
+            if(first.bAny || alternative->IsNullable())
+            {
+                AnyAlternatives.push_back(index);
+                continue;
+            }
+            for (int32 atom : first.Atoms)
+            {
+                AtomAlternatives[atom].push_back(index);
+            }
+            for (int32 terminal : first.Terminals)
+            {
+                TerminalAlternatives[terminal].push_back(index);
+            }
+        }
+        // keep the order of Alternatives in every list
+        auto addAny = [this](Re::Vector<int32>& indices)
+        {
+            Re::Vector<int32> merged;
+            std::merge(indices.begin(), indices.end(), AnyAlternatives.begin(), AnyAlternatives.end(), std::back_inserter(merged));
+            indices = std::move(merged);
+        };
+        for (auto& entry : AtomAlternatives)
+        {
+            addAny(entry.second);
+        }
+        for (auto& entry : TerminalAlternatives)
+        {
+            addAny(entry.second);
+        }
+        // a literal that is also a %token tries the alternatives of both, merged here so Parse never allocates,
+        // pairs adding nothing to the list of the atom are left to it
+        for (auto& byAtom : AtomAlternatives)
+        {
+            for (auto& byTerminal : TerminalAlternatives)
+            {
+                Re::Vector<int32> merged;
+                std::set_union(byAtom.second.begin(), byAtom.second.end(), byTerminal.second.begin(), byTerminal.second.end(), std::back_inserter(merged));
+                if(merged.size() != byAtom.second.size())
+                {
+                    AtomTerminalAlternatives.insert(RE_MAKE_PAIR(GetDispatchKey(byAtom.first, byTerminal.first), std::move(merged)));
+                }
+            }
+        }
+        bDispatch = true;
+    }
+
+    bool OrNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        bool bNullable = false;
+        for (auto& subRule : SubRules)
+        {
+            bNullable |= CollectSubRule(subRule, outRules);
+        }
+        return bNullable;
+    }
+
     Re::String OrNodeParser::ToString() const
     {
         Re::String Result;
@@ -81,14 +374,15 @@ namespace ReParser::AST
         for (auto& subRule : SubRules)
         {
             auto nextToken = context.GetToken();
-            Token currentToken = *nextToken;
+            // rules matching nothing may still succeed at the end of the input
+            Token currentToken = nextToken ? *nextToken : context.GetEndToken();
             auto rule = Re::SharedPtrGet(subRule);
             if(!rule)
             {
                 return false;
             }
             ASTNodePtr subNode;
-            if(!rule->Parse(file, context, currentToken, &subNode))
+            if(!context.ParseRule(*rule, file, currentToken, &subNode))
             {
                 TRACE_AST_PARSE_F("%s try parse %s by %s failed", GetName(), currentToken.GetTokenName().c_str(), rule->ToString().c_str());
                 context.ResetToToken(token);
@@ -97,13 +391,92 @@ namespace ReParser::AST
             else
             {
                 TRACE_AST_PARSE_F("%s try parse %s by %s succ", GetName(), currentToken.GetTokenName().c_str(), rule->ToString().c_str());
-                result->AppendNode(subNode);
+                if(subNode)
+                {
+                    result->AppendNode(subNode);
+                }
             }
         }
 
+        *outNode = result;
         return true;
     }
 
+    void GroupNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        compiler.Emit(EGrammarOp::BeginGroup);
+        for (auto& subRule : SubRules)
+        {
+            if(!subRule)
+            {
+                compiler.Emit(EGrammarOp::Fail);
+                continue;
+            }
+            compiler.EmitParser(*subRule);
+        }
+        compiler.Emit(EGrammarOp::EndGroup);
+    }
+
+    void GroupNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        for (auto& subRule : SubRules)
+        {
+            // named rules resolve on their own, rules may refer to each other in cycles
+            if(subRule && !subRule->IsDefinedParser())
+            {
+                subRule->ResolveAtoms(atoms);
+            }
+        }
+    }
+
+    bool GroupNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        for (auto& subRule : SubRules)
+        {
+            if(!CollectSubRule(subRule, outRules))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool GroupNodeParser::UpdateFirst()
+    {
+        bool bGrew = false;
+        // the group starts with what its leading rules matching nothing are followed by
+        bool bNullable = true;
+        for (auto& subRule : SubRules)
+        {
+            bGrew |= UpdateSubFirst(subRule);
+            if(!bNullable)
+            {
+                continue;
+            }
+            if(!subRule)
+            {
+                // never matches
+                bNullable = false;
+                continue;
+            }
+            bGrew |= MergeFirst(*subRule);
+            bNullable = subRule->IsNullable();
+        }
+        if(bNullable)
+        {
+            bGrew |= MarkNullable();
+        }
+        return bGrew;
+    }
+
+    void GroupNodeParser::BuildDispatch()
+    {
+        for (auto& subRule : SubRules)
+        {
+            BuildSubDispatch(subRule);
+        }
+    }
+
     Re::String GroupNodeParser::ToString() const
     {
         Re::String Result;
@@ -144,7 +517,7 @@ namespace ReParser::AST
         {
             if(!context.TryGetCustomParser(CustomParserName, &RealParser))
             {
-                context.SetError(RE_FORMAT("cannot find custom parser %s %s", CustomParserName.c_str(), context.GetFileLocation(file).c_str()));
+                context.Report(EDiagnosticCode::ASTUnknownCustomParser, { CustomParserName });
                 return false;
             }
         }
@@ -159,16 +532,107 @@ namespace ReParser::AST
         {
             return true;
         }
-        if(!SubRule->Parse(file, context, token, outNode))
+        if(!context.ParseRule(*SubRule, file, token, outNode))
         {
+            // matched nothing, token is left for the next rule
+            outNode->reset();
             context.UngetToken(token);
-            auto nextToken = context.GetToken(file);
-            RE_ASSERT(*nextToken == token);
-            return true;
         }
         return true;
     }
 
+    void OptionNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        if(!SubRule)
+        {
+            return;
+        }
+        const int32 choice = compiler.Emit(EGrammarOp::Choice);
+        compiler.EmitParser(*SubRule);
+        const int32 commit = compiler.Emit(EGrammarOp::Commit);
+        compiler.PatchToHere(choice);
+        compiler.PatchToHere(commit);
+    }
+
+    // Choice End, <rule>, PartialCommit Body, the group collects the nodes of every pass
+    static void CompileRepeat(GrammarCompiler& compiler, ASTNodeParser& subRule, bool bAtLeastOnce)
+    {
+        compiler.Emit(EGrammarOp::BeginGroup);
+        if(bAtLeastOnce)
+        {
+            compiler.EmitParser(subRule);
+        }
+        const int32 choice = compiler.Emit(EGrammarOp::Choice);
+        const int32 body = compiler.GetCodeSize();
+        compiler.EmitParser(subRule);
+        compiler.Emit(EGrammarOp::PartialCommit, body);
+        compiler.PatchToHere(choice);
+        compiler.Emit(EGrammarOp::EndGroup);
+    }
+
+    // passes of a repeat from token, false when not even one matched
+    static bool ParseRepeat(ASTNodeParser& subRule, ICodeFile* file, ASTParser& context, const Token& token, GroupNode& result)
+    {
+        auto startToken = token;
+        bool bMatched = false;
+        while(true)
+        {
+            ASTNodePtr subNode;
+            if(!context.ParseRule(subRule, file, startToken, &subNode))
+            {
+                context.UngetToken(startToken);
+                break;
+            }
+            bMatched = true;
+            if(subNode)
+            {
+                result.AppendNode(subNode);
+            }
+            auto nextToken = context.GetToken();
+            if(!nextToken)
+            {
+                break;
+            }
+            if(nextToken->GetStartPos() == startToken.GetStartPos())
+            {
+                // a pass matching nothing would loop forever
+                context.UngetToken(startToken);
+                break;
+            }
+            startToken = *nextToken;
+        }
+        return bMatched;
+    }
+
+    void OptionNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        if(SubRule && !SubRule->IsDefinedParser())
+        {
+            SubRule->ResolveAtoms(atoms);
+        }
+    }
+
+    bool OptionNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        CollectSubRule(SubRule, outRules);
+        return true;
+    }
+
+    bool OptionNodeParser::UpdateFirst()
+    {
+        bool bGrew = UpdateSubFirst(SubRule) | MarkNullable();
+        if(SubRule)
+        {
+            bGrew |= MergeFirst(*SubRule);
+        }
+        return bGrew;
+    }
+
+    void OptionNodeParser::BuildDispatch()
+    {
+        BuildSubDispatch(SubRule);
+    }
+
     Re::String OptionNodeParser::ToString() const
     {
         Re::String Result;
@@ -194,26 +658,44 @@ namespace ReParser::AST
     {
         Re::SharedPtr<GroupNode> result = Re::MakeShared<GroupNode>();
         *outNode = result;
-        auto startToken = token;
-        while(true)
+        ParseRepeat(*SubRule, file, context, token, *result);
+        return true;
+    }
+
+    void OptionalRepeatNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        CompileRepeat(compiler, *SubRule, false);
+    }
+
+    void OptionalRepeatNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        if(SubRule && !SubRule->IsDefinedParser())
         {
-            ASTNodePtr subNode;
-            if(SubRule->Parse(file, context, startToken, &subNode))
-            {
-                result->AppendNode(subNode);
-                startToken = *context.GetToken();
-            }
-            else
-            {
-                context.UngetToken(startToken);
-                auto nextToken = context.GetToken(file);
-                RE_ASSERT(*nextToken == token);
-                break;
-            }
+            SubRule->ResolveAtoms(atoms);
         }
+    }
+
+    bool OptionalRepeatNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        CollectSubRule(SubRule, outRules);
         return true;
     }
 
+    bool OptionalRepeatNodeParser::UpdateFirst()
+    {
+        bool bGrew = UpdateSubFirst(SubRule) | MarkNullable();
+        if(SubRule)
+        {
+            bGrew |= MergeFirst(*SubRule);
+        }
+        return bGrew;
+    }
+
+    void OptionalRepeatNodeParser::BuildDispatch()
+    {
+        BuildSubDispatch(SubRule);
+    }
+
     Re::String OptionalRepeatNodeParser::ToString() const
     {
         Re::String Result;
@@ -237,30 +719,49 @@ namespace ReParser::AST
     bool RepeatNodeParser::Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
     {
         Re::SharedPtr<GroupNode> result = Re::MakeShared<GroupNode>();
+        if(!ParseRepeat(*SubRule, file, context, token, *result))
+        {
+            return false;
+        }
         *outNode = result;
-        auto startToken = token;
-        while(true)
+        return true;
+    }
+
+    void RepeatNodeParser::Compile(GrammarCompiler& compiler)
+    {
+        CompileRepeat(compiler, *SubRule, true);
+    }
+
+    void RepeatNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        if(SubRule && !SubRule->IsDefinedParser())
         {
-            ASTNodePtr subNode;
-            if(SubRule->Parse(file, context, startToken, &subNode))
-            {
-                result->AppendNode(subNode);
-                startToken = *context.GetToken();
-            }
-            else
-            {
-                context.UngetToken(startToken);
-                auto nextToken = context.GetToken(file);
-                RE_ASSERT(*nextToken == token);
-                break;
-            }
+            SubRule->ResolveAtoms(atoms);
         }
-        if(result->GetSubNodes().empty())
+    }
+
+    bool RepeatNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        return CollectSubRule(SubRule, outRules);
+    }
+
+    bool RepeatNodeParser::UpdateFirst()
+    {
+        bool bGrew = UpdateSubFirst(SubRule);
+        if(SubRule)
         {
-            outNode->reset();
-            return false;
+            bGrew |= MergeFirst(*SubRule);
+            if(SubRule->IsNullable())
+            {
+                bGrew |= MarkNullable();
+            }
         }
-        return true;
+        return bGrew;
+    }
+
+    void RepeatNodeParser::BuildDispatch()
+    {
+        BuildSubDispatch(SubRule);
     }
 
     Re::String RepeatNodeParser::ToString() const
@@ -281,4 +782,228 @@ namespace ReParser::AST
 
         return Result;
     }
-}
+
+    DEFINE_DERIVED_CLASS_WITHOUT_NEW(PrecedenceNodeParser, ASTNodeParser)
+    void PrecedenceNodeParser::TryApply(ASTNodeParser& rule, const Re::Vector<BinaryOperator>& operators)
+    {
+        // BNF rules are a group holding the alternatives
+        auto group = ReClassSystem::CastTo<GroupNodeParser>(&rule);
+        if(!group || group->GetSubRules().size() != 1)
+        {
+            return;
+        }
+        auto grammar = group->GetSubRules()[0];
+        auto alternatives = grammar && !grammar->IsDefinedParser() ? ReClassSystem::CastTo<OrNodeParser>(Re::SharedPtrGet(grammar)) : nullptr;
+        if(!alternatives)
+        {
+            return;
+        }
+
+        auto operand = CreateASTNode<OrNodeParser>();
+        auto op = CreateASTNode<OrNodeParser>();
+        for (auto& alternative : alternatives->GetSubRules())
+        {
+            auto binary = alternative && !alternative->IsDefinedParser() ? ReClassSystem::CastTo<GroupNodeParser>(Re::SharedPtrGet(alternative)) : nullptr;
+            if(binary && binary->GetSubRules().size() == 3 && Re::SharedPtrGet(binary->GetSubRules()[0]) == &rule
+                && Re::SharedPtrGet(binary->GetSubRules()[2]) == &rule && binary->GetSubRules()[1])
+            {
+                op->AddRule(binary->GetSubRules()[1]);
+            }
+            else
+            {
+                operand->AddRule(alternative);
+            }
+        }
+        if(op->GetSubRules().empty() || operand->GetSubRules().empty())
+        {
+            return;
+        }
+
+        auto single = [](const Re::SharedPtr<OrNodeParser>& parser) -> Re::SharedPtr<ASTNodeParser>
+        {
+            if(parser->GetSubRules().size() == 1)
+            {
+                return parser->GetSubRules()[0];
+            }
+            return parser;
+        };
+        group->ClearRules();
+        group->AddRule(CreateASTNode<PrecedenceNodeParser>(grammar, single(operand), single(op), operators));
+    }
+
+    bool PrecedenceNodeParser::Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode)
+    {
+        return ParseExpression(file, context, token, 0, outNode);
+    }
+
+    bool PrecedenceNodeParser::ParseExpression(ICodeFile* file, ASTParser& context, const Token& token, int32 minPrecedence, ASTNodePtr* outNode)
+    {
+        ASTNodePtr left;
+        if(!context.ParseRule(*Operand, file, token, &left))
+        {
+            return false;
+        }
+        // the non-associative operator left was built with, another one of its level cannot follow
+        const BinaryOperator* nonAssocOperator = nullptr;
+        while(true)
+        {
+            auto nextToken = context.GetToken();
+            if(!nextToken)
+            {
+                break;
+            }
+            const Token opToken = *nextToken;
+            const BinaryOperator* binaryOperator = FindOperator(opToken);
+            if(!binaryOperator || binaryOperator->Precedence < minPrecedence)
+            {
+                context.UngetToken(opToken);
+                break;
+            }
+            if(nonAssocOperator && binaryOperator->Precedence == nonAssocOperator->Precedence)
+            {
+                // a == b == c is an error like in yacc, not a == b followed by whatever == c is
+                context.Report(EDiagnosticCode::ASTNonAssocChain, { binaryOperator->Text, nonAssocOperator->Text });
+                context.UngetToken(opToken);
+                return false;
+            }
+            ASTNodePtr opNode;
+            if(std::binary_search(OperatorLiterals.begin(), OperatorLiterals.end(), opToken.GetAtomId()))
+            {
+                opNode = CreateASTNode<IdentifierNode>(opToken);
+                if(bGroupOperator)
+                {
+                    auto group = CreateASTNode<GroupNode>();
+                    group->AppendNode(opNode);
+                    opNode = group;
+                }
+            }
+            else if(!context.ParseRule(*Operator, file, opToken, &opNode))
+            {
+                TRACE_AST_PARSE_F("%s operator %s not matched", GetName(), opToken.GetTokenName().c_str());
+                context.UngetToken(opToken);
+                break;
+            }
+            auto rightToken = context.GetToken();
+            ASTNodePtr right;
+            const int32 rightPrecedence = binaryOperator->Associativity == EOperatorAssociativity::Right ? binaryOperator->Precedence : binaryOperator->Precedence + 1;
+            if(!rightToken || !ParseExpression(file, context, *rightToken, rightPrecedence, &right))
+            {
+                // the operator is left to whoever follows the expression
+                context.UngetToken(opToken);
+                break;
+            }
+
+            auto binary = CreateASTNode<GroupNode>();
+            binary->AppendNode(left);
+            if(opNode)
+            {
+                binary->AppendNode(opNode);
+            }
+            binary->AppendNode(right);
+            left = binary;
+            nonAssocOperator = binaryOperator->Associativity == EOperatorAssociativity::NonAssoc ? binaryOperator : nullptr;
+        }
+        *outNode = left;
+        return true;
+    }
+
+    const BinaryOperator* PrecedenceNodeParser::FindOperator(const Token& token) const
+    {
+        if(!OperatorIndices.empty())
+        {
+            auto it = token.GetAtomId() != 0 ? OperatorIndices.find(token.GetAtomId()) : OperatorIndices.end();
+            return it != OperatorIndices.end() ? &Operators[static_cast<size_t>(it->second)] : nullptr;
+        }
+        for (auto& op : Operators)
+        {
+            if(token.Matches(op.Text.c_str()))
+            {
+                return &op;
+            }
+        }
+        return nullptr;
+    }
+
+    void PrecedenceNodeParser::ResolveAtoms(AtomTable& atoms)
+    {
+        // operands and operators are alternatives of the grammar
+        Grammar->ResolveAtoms(atoms);
+        OperatorIndices.clear();
+        for (size_t i = 0; i < Operators.size(); i++)
+        {
+            // an operator listed twice keeps its first precedence
+            OperatorIndices.insert(RE_MAKE_PAIR(atoms.Intern(Operators[i].Text), static_cast<int32>(i)));
+        }
+    }
+
+    bool PrecedenceNodeParser::CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const
+    {
+        // every expression starts with an operand
+        return CollectSubRule(Operand, outRules);
+    }
+
+    bool PrecedenceNodeParser::UpdateFirst()
+    {
+        bool bGrew = UpdateSubFirst(Operand) | UpdateSubFirst(Operator);
+        bGrew |= MergeFirst(*Operand);
+        if(Operand->IsNullable())
+        {
+            bGrew |= MarkNullable();
+        }
+        return bGrew;
+    }
+
+    // atoms of a parser that only matches single literals, false for any other parser
+    static bool CollectLiterals(ASTNodeParser& parser, Re::Vector<int32>& outAtoms)
+    {
+        if(auto literal = ReClassSystem::CastTo<RequiredIdentifierNodeParser>(&parser))
+        {
+            outAtoms.push_back(literal->GetAtom());
+            return literal->GetAtom() != 0;
+        }
+        auto alternatives = ReClassSystem::CastTo<OrNodeParser>(&parser);
+        if(!alternatives)
+        {
+            return false;
+        }
+        for (auto& alternative : alternatives->GetSubRules())
+        {
+            if(!alternative || alternative->IsDefinedParser() || !CollectLiterals(*alternative, outAtoms))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void PrecedenceNodeParser::BuildDispatch()
+    {
+        BuildSubDispatch(Operand);
+        BuildSubDispatch(Operator);
+
+        // a named <op> rule is a group holding the literals
+        ASTNodeParser* literals = Re::SharedPtrGet(Operator);
+        bGroupOperator = false;
+        if(Operator->IsDefinedParser())
+        {
+            auto group = ReClassSystem::CastTo<GroupNodeParser>(literals);
+            const bool bSingle = group && group->GetSubRules().size() == 1 && group->GetSubRules()[0] && !group->GetSubRules()[0]->IsDefinedParser();
+            literals = bSingle ? Re::SharedPtrGet(group->GetSubRules()[0]) : nullptr;
+            bGroupOperator = true;
+        }
+        OperatorLiterals.clear();
+        Re::Vector<int32> atoms;
+        if(literals && CollectLiterals(*literals, atoms))
+        {
+            // operators missing from the table still end the expression in FindOperator
+            for (int32 atom : atoms)
+            {
+                if(OperatorIndices.count(atom) != 0)
+                {
+                    OperatorLiterals.push_back(atom);
+                }
+            }
+            std::sort(OperatorLiterals.begin(), OperatorLiterals.end());
+        }
+    }
+}
\ No newline at end of file
@@ -15,9 +15,33 @@ namespace ReParser::AST
         {
         }
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
+        void ResolveAtoms(AtomTable& atoms) override { Atom = atoms.Intern(TokenName); }
+        bool UpdateFirst() override { return Atom != 0 ? First.AddAtom(Atom) : First.AddAny(); }
         Re::String ToString() const override;
+        int32 GetAtom() const { return Atom; }
     private:
         Re::String TokenName{};
+        int32 Atom = 0;
+    };
+
+    // <Name> of a %token pattern, matches tokens lexed by that pattern
+    class RECODEPARSER_API TerminalNodeParser : public ASTNodeParser
+    {
+        DECLARE_DERIVED_CLASS(TerminalNodeParser, ASTNodeParser)
+    public:
+        TerminalNodeParser(const Re::String& name, uint16 terminalId)
+          : TokenName(name)
+          , TerminalId(terminalId)
+        {
+        }
+        bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
+        bool UpdateFirst() override { return First.AddTerminal(TerminalId); }
+        Re::String ToString() const override;
+    private:
+        Re::String TokenName{};
+        uint16 TerminalId = 0;
     };
 
     // A | B
@@ -26,11 +50,40 @@ namespace ReParser::AST
         DECLARE_DERIVED_CLASS(OrNodeParser, ASTNodeParser)
     public:
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
-        void AddRule(const Re::SharedPtr<ASTNodeParser>& rule) { SubRules.push_back(rule); }
-        void ClearRules() { SubRules.clear(); }
+        void Compile(GrammarCompiler& compiler) override;
+        void AddRule(const Re::SharedPtr<ASTNodeParser>& rule)
+        {
+            SubRules.push_back(rule);
+            Alternatives.push_back(rule);
+        }
+        const Re::Vector<Re::SharedPtr<ASTNodeParser>>& GetSubRules() const { return SubRules; }
+        void ClearRules()
+        {
+            SubRules.clear();
+            Alternatives.clear();
+        }
+        /** Tries the alternatives bFirst holds for before the others, each part keeps the order of the grammar. */
+        void PreferAlternatives(const Re::Func<bool(const ASTNodeParser& alternative)>& bFirst);
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        /** Sorts the alternatives by the tokens they start with, a token only tries the ones it can start. */
+        void BuildDispatch() override;
         Re::String ToString() const override;
     private:
+        bool TryAlternative(ASTNodeParser& rule, ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode);
+
         Re::Vector<Re::SharedPtr<ASTNodeParser>> SubRules;
+        // SubRules in the order they are tried
+        Re::Vector<Re::SharedPtr<ASTNodeParser>> Alternatives;
+        // indices of the alternatives a token may start by its atom or terminal, in the order they are tried,
+        // AnyAlternatives for other tokens are in every list
+        Re::Map<int32, Re::Vector<int32>> AtomAlternatives;
+        Re::Map<int32, Re::Vector<int32>> TerminalAlternatives;
+        // both lists of a token with an atom and a terminal merged, keyed by GetDispatchKey
+        Re::Map<int64, Re::Vector<int32>> AtomTerminalAlternatives;
+        Re::Vector<int32> AnyAlternatives;
+        bool bDispatch = false;
     };
 
     // (A B)
@@ -39,9 +92,14 @@ namespace ReParser::AST
         DECLARE_DERIVED_CLASS(GroupNodeParser, ASTNodeParser)
     public:
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
         void AddRule(const Re::SharedPtr<ASTNodeParser>& rule) { SubRules.push_back(rule); }
         const Re::Vector<Re::SharedPtr<ASTNodeParser>>& GetSubRules() { return SubRules; }
         void ClearRules() { SubRules.clear(); }
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        void BuildDispatch() override;
         Re::String ToString() const override;
     private:
         Re::Vector<Re::SharedPtr<ASTNodeParser>> SubRules;
@@ -71,6 +129,11 @@ namespace ReParser::AST
         {
         }
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        void BuildDispatch() override;
         Re::String ToString() const override;
     private:
         Re::SharedPtr<ASTNodeParser> SubRule{};
@@ -86,6 +149,11 @@ namespace ReParser::AST
         {
         }
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        void BuildDispatch() override;
         Re::String ToString() const override;
     private:
         Re::SharedPtr<ASTNodeParser> SubRule;
@@ -101,9 +169,57 @@ namespace ReParser::AST
         {
         }
         bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void Compile(GrammarCompiler& compiler) override;
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        void BuildDispatch() override;
         Re::String ToString() const override;
     private:
         Re::SharedPtr<ASTNodeParser> SubRule;
     };
 
+    // <e> ::= <operand> | <e> <op> <e>, binary operators parsed by precedence climbing
+    class RECODEPARSER_API PrecedenceNodeParser : public ASTNodeParser
+    {
+        DECLARE_DERIVED_CLASS(PrecedenceNodeParser, ASTNodeParser)
+    public:
+        /**
+         * Turns the named rule into a precedence climbing one when some of its alternatives are <rule> <op> <rule>,
+         * the others become the operands. Operators missing from the table end the expression.
+         */
+        static void TryApply(ASTNodeParser& rule, const Re::Vector<BinaryOperator>& operators);
+
+        PrecedenceNodeParser(const Re::SharedPtr<ASTNodeParser>& grammar, const Re::SharedPtr<ASTNodeParser>& operand,
+            const Re::SharedPtr<ASTNodeParser>& op, const Re::Vector<BinaryOperator>& operators)
+            : Grammar(grammar)
+            , Operand(operand)
+            , Operator(op)
+            , Operators(operators)
+        {
+        }
+        bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) override;
+        void ResolveAtoms(AtomTable& atoms) override;
+        bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const override;
+        bool UpdateFirst() override;
+        void BuildDispatch() override;
+        Re::String ToString() const override { return Grammar->ToString(); }
+    private:
+        // operands and the operators binding at least minPrecedence, fails on a chain of non-associative ones
+        bool ParseExpression(ICodeFile* file, ASTParser& context, const Token& token, int32 minPrecedence, ASTNodePtr* outNode);
+        const BinaryOperator* FindOperator(const Token& token) const;
+
+        // the alternatives as written, for ToString
+        Re::SharedPtr<ASTNodeParser> Grammar;
+        Re::SharedPtr<ASTNodeParser> Operand;
+        Re::SharedPtr<ASTNodeParser> Operator;
+        Re::Vector<BinaryOperator> Operators;
+        // index in Operators by atom, empty until resolved
+        Re::Map<int32, int32> OperatorIndices;
+        // sorted atoms of the operators Operator matches as a single literal, their nodes are built without running it
+        Re::Vector<int32> OperatorLiterals;
+        // Operator is a named rule, its node is a group around the literal
+        bool bGroupOperator = false;
+    };
+
 }
\ No newline at end of file
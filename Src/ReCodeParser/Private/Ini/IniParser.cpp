@@ -132,7 +132,15 @@ namespace ReParser::Ini
         return MapBuilder;
     }
 
-    class IniParser : public BaseParserWithFile
+    // no block comments, '#' and ';' start line comments
+    struct IniLexPolicy : DefaultLexPolicy
+    {
+        static constexpr bool IsBeginComment(char c, char Next) { return false; }
+        static constexpr bool IsEndComment(char c, char Next) { return false; }
+        static constexpr bool IsLineComment(char c, char Next) { return c == '#' || c == ';'; }
+    };
+
+    class IniParser : public TBaseParser<IniLexPolicy, BaseParserWithFile>
     {
         enum class IniScopeType
         {
@@ -176,10 +184,6 @@ namespace ReParser::Ini
         void PreParserProcess(ICodeFile* file) override;
         void PostParserProcess(ICodeFile* file) override;
         bool CompileDeclaration(ICodeFile* file, const Token& token) override;
-    protected:
-        bool IsBeginComment(char currentChar) override { return false; }
-        bool IsEndComment(char currentChar) override { return false; }
-        bool IsLineComment(char currentChar) override { return currentChar == '#' || currentChar == ';'; }
     private:
         bool CompileFileScope(ICodeFile& file, IniFileScope& fileScope, const Token& token);
         bool CompileSectionScope(ICodeFile& file, IniSectionScope& sectionScope, const Token& token);
@@ -194,19 +198,38 @@ namespace ReParser::Ini
     };
 
 
-    IniFilePtr IniFile::Parse(const Re::String& filePath)
+    static IniFilePtr ParseFile(const Re::String& filePath, Re::String& outError)
     {
         auto result = Re::MakeShared<IniFile>(filePath);
         if(!result->IsValid())
         {
+            outError = RE_FORMAT("read ini file %s failed !!", filePath.c_str());
             return nullptr;
         }
         IniParser parser;
-        parser.InitParserSource(result->GetFilePath(), result->GetContent().c_str());
+        parser.InitParserSource(result->GetFilePath(), result->GetContent().data(), static_cast<int64>(result->GetContent().size()));
         parser.Parse(Re::SharedPtrGet(result));
+        parser.GetError(outError);
         return result;
     }
 
+    IniFilePtr IniFile::Parse(const Re::String& filePath)
+    {
+        Re::String error;
+        return ParseFile(filePath, error);
+    }
+
+    Re::Vector<FileParseResult<IniFile>> IniFile::ParseBatch(const Re::Vector<Re::String>& filePaths, WorkStealingPool& pool)
+    {
+        Re::Vector<FileParseResult<IniFile>> results(filePaths.size());
+        pool.ParallelFor(static_cast<int32>(filePaths.size()), [&](int32 index)
+        {
+            auto& result = results[static_cast<size_t>(index)];
+            result.File = ParseFile(filePaths[static_cast<size_t>(index)], result.Error);
+        });
+        return results;
+    }
+
     Re::String IniFile::ToString() const
     {
         Re::String result;
@@ -235,14 +258,14 @@ namespace ReParser::Ini
     {
         if(file == nullptr)
         {
-            SetError("code file is null !!");
+            Report(EDiagnosticCode::IniNullFile);
             return;
         }
 
         auto iniFile = ReClassSystem::CastTo<IniFile>(file);
         if(!iniFile)
         {
-            SetError(RE_FORMAT("current code file is not a ini file !! %s", file->GetFilePath().c_str()));
+            Report(EDiagnosticCode::IniNotIniFile, { file->GetFilePath() });
             return;
         }
         ScopeStack.push(Re::MakeShared<IniFileScope>(iniFile));
@@ -295,14 +318,14 @@ namespace ReParser::Ini
                 }
             default:
                 {
-                    SetError(RE_FORMAT("unexcepted scope !!! %s", GetFileLocation(file).c_str()));
+                    Report(EDiagnosticCode::IniUnexpectedScope);
                     return false;
                 }
             }
         }
         else
         {
-            SetError(RE_FORMAT("scope or file is null !!! %s", GetFileLocation(file).c_str()));
+            Report(EDiagnosticCode::IniNullScope);
             return false;
         }
     }
@@ -316,14 +339,14 @@ namespace ReParser::Ini
             auto nameToken = GetToken(true);
             if(!nameToken)
             {
-                SetError(RE_FORMAT("unexcepted end of file %s", GetFileLocation(&file)));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
             if(nameToken->Matches(']'))
             {
                 if(nameBuilder.empty())
                 {
-                    SetError(RE_FORMAT("ini section item name is empty %s", GetFileLocation(&file)));
+                    Report(EDiagnosticCode::IniEmptyItemName);
                     return false;
                 }
                 break;
@@ -334,7 +357,7 @@ namespace ReParser::Ini
         auto newSection = Re::MakeShared<IniSection>(nameBuilder);
         if(!fileScope.File->AddSection(nameBuilder, newSection))
         {
-            SetError(RE_FORMAT("ini section %s has added !!", nameBuilder.c_str()));
+            Report(EDiagnosticCode::IniDuplicateSection, { nameBuilder });
             return false;
         }
 
@@ -359,11 +382,10 @@ namespace ReParser::Ini
         Token currentNameToken;
         if(isList)
         {
-            auto nextNameToken = GetToken(true);
-            const Token* sectionItemNameTokenPtr = Re::SharedPtrGet(nextNameToken);
+            const Token* sectionItemNameTokenPtr = GetToken(true);
             if(!sectionItemNameTokenPtr)
             {
-                SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
             currentNameToken = *sectionItemNameTokenPtr;
@@ -377,14 +399,14 @@ namespace ReParser::Ini
         {
             if(currentNameToken.GetTokenType() == ETokenType::Const)
             {
-                SetError(RE_FORMAT("section item name cannot be const value !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniConstItemName);
                 return false;
             }
             sectionNameBuilder += currentNameToken.GetTokenName();
             auto nextToken = GetToken(true);
             if(!nextToken)
             {
-                SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
             currentNameToken = *nextToken;
@@ -406,7 +428,7 @@ namespace ReParser::Ini
             item = sectionScope.Section->GetItem(sectionNameBuilder);
             if(item != nullptr)
             {
-                SetError(RE_FORMAT("section item %s has been added %s", sectionNameBuilder.c_str(), GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniDuplicateItem, { sectionNameBuilder });
                 return false;
             }
             auto newItem = IniSectionItem::CreateSingle();
@@ -439,7 +461,7 @@ namespace ReParser::Ini
             auto result = ParseValue(file, token);
             if (!result)
             {
-                SetError(RE_FORMAT("parse ini section item failed !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniItemFailed);
             }
             item->GetList()->push_back(result);
             ScopeStack.pop();
@@ -450,7 +472,7 @@ namespace ReParser::Ini
             // can never reach here now, but remain here for future features?
             if(token.GetTokenType() != ETokenType::Identifier)
             {
-                SetError(RE_FORMAT("must start with a identify !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniExpectedIdentifier);
                 return false;
             }
 
@@ -459,7 +481,7 @@ namespace ReParser::Ini
             auto result = ParseValue(file, token);
             if(!result)
             {
-                SetError(RE_FORMAT("parse ini section item failed !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniItemFailed);
             }
             item->GetMap()->insert(RE_MAKE_PAIR(name, result));
             ScopeStack.pop();
@@ -470,14 +492,14 @@ namespace ReParser::Ini
         {
             // should never reach
             RE_ASSERT(false);
-            SetError("unknown error !! please review parser code..");
+            Report(EDiagnosticCode::InternalError);
             return false;
         }
     }
 
     IniSectionItemPtr IniParser::ParseValue(ICodeFile& file, const Token& token)
     {
-        auto currentLine = InputLine;
+        auto currentLine = GetInputLine();
         IniSectionItemPtr newItem;
         if(token.Matches('('))
         {
@@ -514,7 +536,7 @@ namespace ReParser::Ini
                     }
                     if(itemContentToken.GetTokenType() != ETokenType::Identifier)
                     {
-                        SetError(RE_FORMAT("invalid token type !! %s", GetFileLocation(&file).c_str()));
+                        Report(EDiagnosticCode::IniInvalidToken);
                         return nullptr;
                     }
                     itemContentBuilder += itemContentToken.GetTokenName();
@@ -524,7 +546,7 @@ namespace ReParser::Ini
                     {
                        break;
                     }
-                    if(InputLine != currentLine)
+                    if(GetInputLine() != currentLine)
                     {
                         UngetToken(nextToken);
                         break;
@@ -538,7 +560,7 @@ namespace ReParser::Ini
             }
             else
             {
-                SetError(RE_FORMAT("unexpected token type %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniUnexpectedToken);
                 return nullptr;
             }
             newItem = IniSectionItem::CreateString(itemContentBuilder);
@@ -560,7 +582,7 @@ namespace ReParser::Ini
             auto token = GetToken();
             if(!token)
             {
-                SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
 
@@ -581,7 +603,7 @@ namespace ReParser::Ini
             {
                 if(mapItemNameToken->GetTokenType() == ETokenType::Const)
                 {
-                    SetError(RE_FORMAT("invalid map item name %s : %s", mapItemNameToken->GetConstantValue().c_str(), GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::IniInvalidMapItemName, { mapItemNameToken->GetConstantValue() });
                     return false;
                 }
                 mapItemNameBuilder += mapItemNameToken->GetTokenName();
@@ -589,7 +611,7 @@ namespace ReParser::Ini
 
                 if(!mapItemNameToken)
                 {
-                    SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                    Report(EDiagnosticCode::UnexpectedEndOfFile);
                     return false;
                 }
             }
@@ -597,14 +619,14 @@ namespace ReParser::Ini
             auto nextToken = GetToken();
             if (!nextToken)
             {
-                SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
 
             auto subItem = ParseValue(file, *nextToken);
             if(!subItem)
             {
-                SetError(RE_FORMAT("failed to parse section item %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniItemFailed);
                 return false;
             }
 
@@ -612,7 +634,7 @@ namespace ReParser::Ini
             RE_ASSERT(map);
             if(map->find(mapItemNameBuilder) != map->end())
             {
-                SetError(RE_FORMAT("repeat key in map item !! %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniDuplicateMapKey);
                 return false;
             }
             map->insert(RE_MAKE_PAIR(mapItemNameBuilder, subItem));
@@ -635,7 +657,7 @@ namespace ReParser::Ini
 
             if(!token)
             {
-                SetError(RE_FORMAT("unexpected end of file %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::UnexpectedEndOfFile);
                 return false;
             }
 
@@ -653,7 +675,7 @@ namespace ReParser::Ini
             auto subItem = ParseValue(file, *token);
             if (!subItem)
             {
-                SetError(RE_FORMAT("failed to parse section item %s", GetFileLocation(&file).c_str()));
+                Report(EDiagnosticCode::IniItemFailed);
                 return false;
             }
 
@@ -0,0 +1,51 @@
+#include "AtomTable.h"
+
+namespace ReParser
+{
+	AtomTable::AtomTable()
+	{
+		Slots.assign(64, 0);
+	}
+
+	int32 AtomTable::Intern(std::string_view Text)
+	{
+		const uint32 TextHash = Hash(Text);
+		uint32 Slot = FindSlot(Text, TextHash);
+		if (Slots[Slot] != 0)
+		{
+			return Slots[Slot];
+		}
+
+		Entry Info;
+		Info.Offset = static_cast<uint32>(Chars.size());
+		Info.Length = static_cast<uint32>(Text.size());
+		Info.Hash = TextHash;
+		Chars.append(Text.data(), Text.size());
+		Entries.push_back(Info);
+
+		const int32 Atom = static_cast<int32>(Entries.size());
+		if (Entries.size() * 2 > Slots.size())
+		{
+			Grow();
+			Slot = FindSlot(Text, TextHash);
+		}
+		Slots[Slot] = Atom;
+		return Atom;
+	}
+
+	void AtomTable::Grow()
+	{
+		Slots.assign(Slots.size() * 2, 0);
+		const uint32 Mask = static_cast<uint32>(Slots.size()) - 1;
+		// the last entry is placed by Intern
+		for (size_t i = 0; i + 1 < Entries.size(); i++)
+		{
+			uint32 Slot = Entries[i].Hash & Mask;
+			while (Slots[Slot] != 0)
+			{
+				Slot = (Slot + 1) & Mask;
+			}
+			Slots[Slot] = static_cast<int32>(i) + 1;
+		}
+	}
+}
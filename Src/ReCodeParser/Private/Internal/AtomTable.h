@@ -0,0 +1,83 @@
+#pragma once
+#include <cstring>
+#include <string_view>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * String interner of a parser. Every distinct identifier or symbol text gets an atom,
+	 * so comparing two texts interned in the same table is an integer compare.
+	 * Atoms start at 1, 0 means no atom.
+	 */
+	class RECODEPARSER_API AtomTable
+	{
+	public:
+		AtomTable();
+
+		/** @return the atom of Text, a new one when Text was never interned. */
+		int32 Intern(std::string_view Text);
+
+		/** @return the atom of Text, 0 when Text was never interned. */
+		int32 Find(std::string_view Text) const
+		{
+			return Slots[FindSlot(Text, Hash(Text))];
+		}
+
+		std::string_view GetAtom(int32 Atom) const
+		{
+			const Entry& Info = Entries[Atom - 1];
+			return std::string_view{ Chars.data() + Info.Offset, Info.Length };
+		}
+
+		int32 Num() const { return static_cast<int32>(Entries.size()); }
+
+	private:
+		struct Entry
+		{
+			uint32 Offset = 0;
+			uint32 Length = 0;
+			uint32 Hash = 0;
+		};
+
+		static uint32 Hash(std::string_view Text)
+		{
+			uint32 Result = 2166136261u;
+			for (const char c : Text)
+			{
+				Result = (Result ^ static_cast<uint8>(c)) * 16777619u;
+			}
+			return Result ^ (Result >> 15);
+		}
+
+		/** @return the slot holding the atom of Text, or the empty slot where it goes. */
+		uint32 FindSlot(std::string_view Text, uint32 TextHash) const
+		{
+			const uint32 Mask = static_cast<uint32>(Slots.size()) - 1;
+			for (uint32 Slot = TextHash & Mask;; Slot = (Slot + 1) & Mask)
+			{
+				const int32 Atom = Slots[Slot];
+				if (Atom == 0)
+				{
+					return Slot;
+				}
+				const Entry& Info = Entries[Atom - 1];
+				if (Info.Hash == TextHash && Info.Length == Text.size()
+					&& std::memcmp(Chars.data() + Info.Offset, Text.data(), Text.size()) == 0)
+				{
+					return Slot;
+				}
+			}
+		}
+
+		void Grow();
+
+		// text of every atom back to back, entries keep offsets since the buffer moves as it grows
+		Re::String Chars;
+		// atom - 1 -> text
+		Re::Vector<Entry> Entries;
+		// open addressing hash, kept at most half full
+		Re::Vector<int32> Slots;
+	};
+}
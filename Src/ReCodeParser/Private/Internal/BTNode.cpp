@@ -2,5 +2,5 @@
 
 namespace BTNodeInternal
 {
-    std::string BTNodeBuilder;
+    thread_local std::string BTNodeBuilder;
 }
\ No newline at end of file
@@ -21,7 +21,8 @@
 
 namespace BTNodeInternal
 {
-	extern std::string BTNodeBuilder;
+	// per thread so trees are printed concurrently
+	extern thread_local std::string BTNodeBuilder;
 }
 
 // Node class
@@ -38,8 +39,9 @@ class BTNode
 	static void initializeClass(childrenGetterFcn f1, dataGetterFcn f2);
 
   private:
-	static childrenGetterFcn childrenGetter;
-	static dataGetterFcn	 dataGetter;
+	// set by the tree being printed on this thread
+	static thread_local childrenGetterFcn childrenGetter;
+	static thread_local dataGetterFcn	 dataGetter;
 
 	std::list<T *> getChildren();
 	std::string    getData();
@@ -13,10 +13,10 @@
 
 
 template <class T>
-typename BTNode<T>::childrenGetterFcn BTNode<T>::childrenGetter = nullptr;
+thread_local typename BTNode<T>::childrenGetterFcn BTNode<T>::childrenGetter = nullptr;
 
 template <class T>
-typename BTNode<T>::dataGetterFcn     BTNode<T>::dataGetter = nullptr;
+thread_local typename BTNode<T>::dataGetterFcn     BTNode<T>::dataGetter = nullptr;
 
 /** **************************************************
  * ***************** Static Adaptor ******************
@@ -1,5 +1,10 @@
 #include "BaseParser.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
 #include "Token.h"
 
 namespace ReParser
@@ -14,13 +19,54 @@ namespace ReParser
 
 	void BaseParser::InitParserSource(const Re::String& InFileName, const char* SourceBuffer)
 	{
+		InitParserSource(InFileName, SourceBuffer, static_cast<int64>(std::strlen(SourceBuffer)));
+	}
+
+	void BaseParser::InitParserSource(const Re::String& InFileName, const char* SourceBuffer, int64 SourceLength)
+	{
+		Stream.Close();
 		Input = SourceBuffer;
-		InputLen = static_cast<int32>(std::strlen(SourceBuffer));
+		InputLen = SourceLength;
 		InputPos = 0;
-		InputLine = 1;
 		PrevPos = 0;
-		PrevLine = 1;
+		Diagnostics.Locate(Lines);
+		Lines.Reset(Input, InputLen);
 		FileName = InFileName;
+		Diagnostics.SetFileName(FileName);
+		RecycleTokens();
+		ClearComment();
+		bPreTokenized = false;
+		if (bPreTokenize)
+		{
+			PreTokenize();
+		}
+	}
+
+	void BaseParser::InitParserStream(const Re::String& InFileName, StreamSource::ReaderFunc Reader, int64 ChunkSize)
+	{
+		Stream.Open(std::move(Reader), ChunkSize);
+		StartStream(InFileName);
+	}
+
+	void BaseParser::InitParserStream(const Re::String& InFileName, int FileDescriptor, int64 ChunkSize)
+	{
+		Stream.Open(FileDescriptor, ChunkSize);
+		StartStream(InFileName);
+	}
+
+	void BaseParser::StartStream(const Re::String& InFileName)
+	{
+		InputPos = 0;
+		PrevPos = 0;
+		StreamKeepPos = 0;
+		Diagnostics.Locate(Lines);
+		FileName = InFileName;
+		Diagnostics.SetFileName(FileName);
+		RecycleTokens();
+		ClearComment();
+		bPreTokenized = false;
+		Input = Stream.Fill(0, Stream.GetChunkSize(), InputLen);
+		Lines.Reset(Input, InputLen);
 	}
 
 	bool BaseParser::ParseWithoutFile()
@@ -40,6 +86,7 @@ namespace ReParser
 			}
 
 			CompileDeclaration(*token);
+			RecycleTokens();
 		}
 
 		return true;
@@ -54,461 +101,525 @@ namespace ReParser
 
 	char BaseParser::GetChar(bool bLiteral)
 	{
-		bool bInsideComment = false;
+		return GetCharWith<VirtualLexRules>(bLiteral);
+	}
 
-		PrevPos = InputPos;
-		PrevLine = InputLine;
+	char BaseParser::GetLeadingChar()
+	{
+		return GetLeadingCharWith<VirtualLexRules>();
+	}
 
-	Loop:
-		const char c = Input[InputPos++];
-		if (bInsideComment)
+	int32 BaseParser::SkipWhitespaceRun()
+	{
+		int32 Newlines = 0;
+		InputPos = Scan::SkipWhitespace(Input + InputPos, Input + InputLen, Newlines) - Input;
+		return Newlines;
+	}
+
+	void BaseParser::ValidateUtf8(const Token& InToken)
+	{
+		const char* Begin = Input + InToken.StartPos;
+		const char* End = Begin + InToken.Length;
+		const char* Invalid = Scan::FindInvalidUtf8(Begin, End);
+		if (Invalid != End)
 		{
-			// Record the character as a comment.
-			PrevComment += c;
+			ReportAt(EDiagnosticCode::InvalidUtf8, Invalid - Input);
 		}
+	}
 
-		if (c == '\n')
+	int32 BaseParser::ClampTokenLength(int64 Length)
+	{
+		constexpr int32 MaxLength = std::numeric_limits<int32>::max();
+		if (Length > MaxLength)
 		{
-			InputLine++;
+			Report(EDiagnosticCode::TokenTooLong, { Length, MaxLength });
+			return MaxLength;
 		}
-		else if (!bLiteral)
-		{
-			const char NextChar = PeekChar();
-			if (IsBeginComment(c))
-			{
-				if (!bInsideComment)
-				{
-					ClearComment();
-					// Record the slash and star.
-					PrevComment += c;
-					PrevComment += NextChar;
-					bInsideComment = true;
-
-					// Move past the star. Do it only when not in comment,
-					// otherwise end of comment might be missed e.g.
-					// /*/ Comment /*/
-					// ~~~~~~~~~~~~~^ Will report second /* as beginning of comment
-					// And throw error that end of file is found in comment.
-					InputPos++;
-				}
+		return static_cast<int32>(Length);
+	}
 
-				goto Loop;
-			}
-			else if (IsEndComment(c))
-			{
-				if (!bInsideComment)
-				{
-					ClearComment();
-					SetError(Re::String{"Unexpected '*/' outside of comment : at "} + GetLocation());
-				}
+	char BaseParser::GetStringChar()
+	{
+		return GetStringCharWith<VirtualLexRules>();
+	}
 
-				/** Asterisk and slash always end comment. */
-				bInsideComment = false;
+	void BaseParser::UngetChar()
+	{
+		InputPos = PrevPos;
+	}
 
-				// Star already recorded; record the slash.
-				PrevComment += Input[InputPos];
+	void BaseParser::SetError(const Re::String& str)
+	{
+		Report(EDiagnosticCode::Custom, { str });
+	}
 
-				InputPos++;
-				goto Loop;
-			}
+	bool BaseParser::GetError(Re::String& str)
+	{
+		if (!Diagnostics.HasErrors())
+		{
+			return false;
 		}
-
-		if (bInsideComment)
+		Diagnostics.Locate(Lines);
+		const Re::Vector<Diagnostic>& Reported = Diagnostics.GetDiagnostics();
+		for (const Diagnostic& Entry : Reported)
 		{
-			if (c == 0)
-			{
-				ClearComment();
-				SetError("End of class header encountered inside comment at : " + GetLocation());
-			}
-			goto Loop;
+			str += Diagnostics.Format(Entry) + "\n";
 		}
-		return c;
+		const int32 Dropped = Diagnostics.GetErrorCount() + Diagnostics.GetWarningCount() - static_cast<int32>(Reported.size());
+		if (Dropped > 0)
+		{
+			str += std::to_string(Dropped) + " more diagnostics not kept\n";
+		}
+		return true;
 	}
 
-	char BaseParser::PeekChar()
+	bool BaseParser::IsEOL(char c)
 	{
-		return (InputPos < InputLen) ? Input[InputPos] : 0;
+		return CharClassTable::Default().IsEOL(c);
 	}
 
-	char BaseParser::GetLeadingChar()
+	bool BaseParser::IsWhitespace(char c)
 	{
-		char TrailingCommentNewline = 0;
-
-		for (;;)
-		{
-			bool MultipleNewlines = false;
-
-			char c;
+		return CharClassTable::Default().IsWhitespace(c);
+	}
 
-			// Skip blanks.
-			do
-			{
-				c = GetChar();
+	void BaseParser::SetCharClassTable(const CharClassTable& Table)
+	{
+		CharClasses = &Table;
+		// the kernels hard-code the default classes
+		bScanKernels = &Table == &CharClassTable::Default();
+	}
 
-				// Check if we've encountered another newline since the last one
-				if (c == TrailingCommentNewline)
-				{
-					MultipleNewlines = true;
-				}
-			} while (IsWhitespace(c));
+	#pragma endregion
 
-			if (!IsLineComment(c))
-			{
-				return c;
-			}
+	void BaseParser::ClearComment()
+	{
+		Comments.clear();
+	}
 
-			// Clear the comment if we've encountered newlines since the last comment
-			if (MultipleNewlines)
+	// newlines in the text between Begin and End, -1 when it is not only whitespace
+	static int64 CountBlankNewlines(const CharClassTable& Classes, const char* Begin, const char* End)
+	{
+		int64 Newlines = 0;
+		for (; Begin < End; Begin++)
+		{
+			if (!Classes.IsWhitespace(*Begin))
 			{
-				ClearComment();
+				return -1;
 			}
+			Newlines += *Begin == '\n';
+		}
+		return Newlines;
+	}
 
-			// Record the first slash.  The first iteration of the loop will get the second slash.
-			PrevComment += c;
-
-			do
-			{
-				c = GetChar(true);
-				if (c == 0)
-					return c;
-				PrevComment += c;
-			} while (!IsEOL(c));
-
-			TrailingCommentNewline = c;
+	Re::String BaseParser::GetDocComment(const Token& InToken) const
+	{
+		// the last comment ending before the token, with nothing but whitespace up to it
+		const int64 TokenPos = InToken.GetStartPos();
+		const auto After = std::upper_bound(Comments.begin(), Comments.end(), TokenPos,
+			[](int64 Pos, const CommentSpan& Comment) { return Pos < Comment.GetEndPos(); });
+		if (After == Comments.begin() || CountBlankNewlines(*CharClasses, Input + (After - 1)->GetEndPos(), Input + TokenPos) < 0)
+		{
+			return {};
+		}
 
-			for (;;)
+		// the comments before it down to a blank line
+		auto First = After - 1;
+		while (First != Comments.begin())
+		{
+			const int64 Newlines = CountBlankNewlines(*CharClasses, Input + (First - 1)->GetEndPos(), Input + First->Offset);
+			if (Newlines < 0 || Newlines > 1)
 			{
-				c = GetChar();
-				if (c == 0)
-					return c;
-				if (c == TrailingCommentNewline || !IsEOL(c))
-				{
-					UngetChar();
-					break;
-				}
-
-				PrevComment += c;
+				break;
 			}
+			--First;
 		}
+		const int64 End = (After - 1)->GetEndPos();
+		return Re::String(Input + First->Offset, static_cast<size_t>(End - First->Offset));
 	}
 
-	void BaseParser::UngetChar()
+	const Token* BaseParser::GetToken(bool bNoConsts)
 	{
-		InputPos = PrevPos;
-		InputLine = PrevLine;
+		if (Diagnostics.ShouldAbort())
+		{
+			return nullptr;
+		}
+		Token* token = Tokens.Allocate();
+		if (!LexToken(*token, bNoConsts))
+		{
+			return nullptr;
+		}
+		return token;
 	}
 
-	void BaseParser::SetError(const Re::String& str)
+	void BaseParser::RecycleTokens()
 	{
-		Errors.push_back(str);
+		Tokens.Reset();
+		if (Stream.IsOpen())
+		{
+			StreamKeepPos = InputPos;
+			Stream.ReleaseRetired();
+			// the text of the comments before it may be dropped
+			Comments.erase(Comments.begin(), std::lower_bound(Comments.begin(), Comments.end(), StreamKeepPos,
+				[](const CommentSpan& Comment, int64 Pos) { return Comment.Offset < Pos; }));
+		}
 	}
 
-	bool BaseParser::GetError(Re::String& str)
+	void BaseParser::FillStream(int64 MinEnd)
 	{
-		if(Errors.empty())
+		const int64 KeepPos = std::min({ StreamKeepPos, PrevPos, InputPos });
+		// the text before KeepPos may be dropped, count its lines first
+		Lines.GetLine(KeepPos);
+		const bool bWasAtEnd = Stream.IsAtEnd();
+		Input = Stream.Fill(KeepPos, MinEnd, InputLen);
+		Lines.Extend(Input, InputLen);
+		if (!bWasAtEnd && Stream.HasFailed())
 		{
-			return false;
+			Report(EDiagnosticCode::StreamReadError);
 		}
-		for (const auto& error : Errors)
-		{
-			str += error + "\n";
-		}
-		return true;
 	}
 
-	bool BaseParser::IsEOL(char c)
+	std::string_view BaseParser::GetSource() const
 	{
-		return c == '\n' || c == '\r' || c == 0;
+		if (Stream.IsOpen())
+		{
+			const int64 Begin = Stream.GetWindowBegin();
+			return std::string_view{ Input + Begin, static_cast<size_t>(InputLen - Begin) };
+		}
+		return std::string_view{ Input, static_cast<size_t>(InputLen) };
 	}
 
-	bool BaseParser::IsWhitespace(char c)
+	static bool IsNumberConst(const Token& InToken)
 	{
-		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		switch (InToken.GetConstType())
+		{
+		case ETokenConstType::Byte:
+		case ETokenConstType::Int:
+		case ETokenConstType::Int64:
+		case ETokenConstType::Float:
+		case ETokenConstType::Double:
+			return true;
+		default:
+			return false;
+		}
 	}
 
-	#pragma endregion
-
-	void BaseParser::ClearComment()
+	void BaseParser::PreTokenize()
 	{
-		PrevComment.clear();
-	}
+		bPreTokenized = false;
+		ConstTokens.Reset();
+		NoConstTokens.Reset();
 
-	Re::SharedPtr<Token> BaseParser::GetToken(bool bNoConsts)
-	{
-		char c = GetLeadingChar();
-		if (c == 0)
+		Token Next;
+		while (LexToken(Next, false))
 		{
-			UngetChar();
-			return nullptr;
+			ConstTokens.Add(Next);
 		}
+		PreTokenizedEndPos = InputPos;
 
-		auto token = Re::MakeShared<Token>();
-		token->StartPos = PrevPos;
-		token->StartLine = PrevLine;
-
-		char p = PeekChar();
-		if((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c == '_'))
+		// The no-const view only differs on number constants, which split into symbols and identifiers,
+		// and on true/false/nullptr, which stay identifiers. Everything else is shared with the const view.
+		const int32 Count = ConstTokens.Num();
+		int32 Index = 0;
+		while (Index < Count)
 		{
-			int32 Length = 0;
-			do
+			const Token& Current = ConstTokens[Index];
+			if (!IsNumberConst(Current))
 			{
-				token->Identifier[Length++] = c;
-				if(Length > Token::NameSize)
+				Next = Current;
+				if (Next.TokenType == ETokenType::Const && Next.ConstType != ETokenConstType::String)
 				{
-					SetError(Re::String{"Identifer length exceeds maximum of "} + std::to_string(Token::NameSize) + " : at " + GetLocation());
-					Length = ((int32)Token::NameSize) - 1;
-					break;
+					Next.TokenType = ETokenType::Identifier;
+					Next.ConstType = ETokenConstType::None;
+					Next.Value.Int64 = 0;
+					if (Keywords)
+					{
+						Next.Value.Identifier.KeywordId = Keywords->Find(Next.GetTokenView());
+					}
+					if (Atoms)
+					{
+						Next.Value.Identifier.AtomId = Atoms->Intern(Next.GetTokenView());
+					}
 				}
-				c = GetChar();
-			} while ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (c == '_'));
-			UngetChar();
-			token->Identifier[Length] = 0;
-			// Assume this is an identifier unless we find otherwise.
-			token->TokenType = ETokenType::Identifier;
+				NoConstTokens.Add(Next);
+				Index++;
+				continue;
+			}
 
-			if(!bNoConsts)
+			// lex the number without consts until both views meet again on a token boundary
+			InputPos = Current.StartPos;
+			while (LexToken(Next, true))
 			{
-				if(token->Matches("true"))
+				NoConstTokens.Add(Next);
+				while (Index < Count && ConstTokens[Index].GetEndPos() <= InputPos)
 				{
-					token->SetConstBool(true);
-					return token;
+					Index++;
 				}
-				else if(token->Matches("false"))
+				if (Index == Count || (ConstTokens[Index].StartPos >= InputPos && !IsNumberConst(ConstTokens[Index])))
 				{
-					token->SetConstBool(false);
-					return token;
-				}
-				else if(token->Matches("nullptr"))
-				{
-					token->SetNullptr();
+					break;
 				}
 			}
-			return token;
 		}
-		// if const values are allowed, determine whether the non-identifier token represents a const
-		else if (!bNoConsts && ((c >= '0' && c <= '9') || ((c == '+' || c == '-') && (p >= '0' && p <= '9'))))
+
+		InputPos = 0;
+		PrevPos = 0;
+		bPreTokenized = true;
+	}
+
+	bool BaseParser::ApplyEdit(int64 Offset, int64 RemovedLength, std::string_view InsertedText, TokenEditRange& OutRange)
+	{
+		if (!bPreTokenized)
+		{
+			Report(EDiagnosticCode::EditNotPreTokenized);
+			return false;
+		}
+		if (Offset < 0 || RemovedLength < 0 || Offset + RemovedLength > InputLen)
 		{
-			// Integer or floating point constant.
-			bool  bIsFloat = 0;
-			int32 Length = 0;
-			bool  bIsHex = 0;
+			ReportAt(EDiagnosticCode::EditOutOfRange, -1, { Offset, RemovedLength });
+			return false;
+		}
 
-			do
+		if (Input != EditedSource.c_str())
+		{
+			EditedSource.assign(Input, static_cast<size_t>(InputLen));
+		}
+		TextEdit Edit;
+		Edit.Offset = Offset;
+		Edit.OldEnd = Offset + RemovedLength;
+		Edit.NewEnd = Offset + static_cast<int64>(InsertedText.size());
+		Edit.PosDelta = Edit.NewEnd - Edit.OldEnd;
+
+		EditedSource.replace(static_cast<size_t>(Offset), static_cast<size_t>(RemovedLength), InsertedText);
+		Input = EditedSource.c_str();
+		InputLen = static_cast<int64>(EditedSource.size());
+		Diagnostics.Locate(Lines);
+		Lines.Truncate(Input, InputLen, Offset);
+
+		// comments touching the edit are lexed again into their own table, starting with the comment before them
+		// so the re-lexing does not record it twice
+		const auto Touched = std::lower_bound(Comments.begin(), Comments.end(), Offset,
+			[](const CommentSpan& Comment, int64 Pos) { return Comment.GetEndPos() < Pos; });
+		const size_t TouchedIndex = static_cast<size_t>(Touched - Comments.begin());
+		const size_t MovedIndex = static_cast<size_t>(std::lower_bound(Touched, Comments.end(), Edit.OldEnd,
+			[](const CommentSpan& Comment, int64 Pos) { return Comment.Offset < Pos; }) - Comments.begin());
+		Re::Vector<CommentSpan> Recorded;
+		Recorded.swap(Comments);
+		if (TouchedIndex > 0)
+		{
+			Comments.push_back(Recorded[TouchedIndex - 1]);
+		}
+
+		// the end of the tokens moves with the edit unless the re-lexing runs up to it
+		PreTokenizedEndPos += Edit.PosDelta;
+		bPreTokenized = false;
+		int64 NoConstRelexEnd = 0;
+		int64 RelexEnd = 0;
+		RelexEdit(NoConstTokens, true, Edit, NoConstRelexEnd);
+		OutRange = RelexEdit(ConstTokens, false, Edit, RelexEnd);
+		RelexEnd = std::max(RelexEnd, NoConstRelexEnd);
+
+		// the comments after the edit move with it, those the re-lexing reached are replaced by the re-lexed ones
+		for (auto It = Recorded.begin() + MovedIndex; It != Recorded.end(); ++It)
+		{
+			It->Offset += Edit.PosDelta;
+		}
+		const auto Kept = std::lower_bound(Recorded.begin() + MovedIndex, Recorded.end(), RelexEnd,
+			[](const CommentSpan& Comment, int64 Pos) { return Comment.Offset < Pos; });
+		const auto Relexed = Comments.begin() + (TouchedIndex > 0 ? 1 : 0);
+		Recorded.insert(Recorded.erase(Recorded.begin() + TouchedIndex, Kept), Relexed, Comments.end());
+		Comments.swap(Recorded);
+
+		RecycleTokens();
+		InputPos = 0;
+		PrevPos = 0;
+		bPreTokenized = true;
+		return true;
+	}
+
+	// whether a re-lexed token is an old token moved by the edit
+	static bool IsMovedToken(const Token& OldToken, const Token& NewToken, int64 PosDelta)
+	{
+		return OldToken.GetStartPos() + PosDelta == NewToken.GetStartPos()
+			&& OldToken.GetEndPos() + PosDelta == NewToken.GetEndPos()
+			&& OldToken.GetTokenType() == NewToken.GetTokenType()
+			&& OldToken.GetConstType() == NewToken.GetConstType()
+			&& OldToken.GetTerminalId() == NewToken.GetTerminalId()
+			&& OldToken.Value.Int64 == NewToken.Value.Int64;
+	}
+
+	TokenEditRange BaseParser::RelexEdit(TokenArray& Array, bool bNoConsts, const TextEdit& Edit, int64& OutRelexEnd)
+	{
+		// the last token starting before the edit may grow into it, the lexer state at a token start is only its position
+		TokenEditRange Range;
+		const int32 BeforeEdit = Array.LowerBound(Edit.Offset) - 1;
+		Range.First = std::max(BeforeEdit, 0);
+		InputPos = PrevPos = BeforeEdit >= 0 ? Array[BeforeEdit].StartPos : 0;
+
+		// old tokens after the removed text may reappear moved by the edit, the first one that does ends the re-lexing
+		int32 OldIndex = Array.LowerBound(Edit.OldEnd);
+		bool bResynced = false;
+		Re::Vector<Token> NewTokens;
+		Token Next;
+		while (LexToken(Next, bNoConsts))
+		{
+			if (Next.StartPos >= Edit.NewEnd)
 			{
-				if (c == '.')
-				{
-					bIsFloat = true;
-				}
-				if (c == 'X' || c == 'x')
+				while (OldIndex < Array.Num() && Array.GetStartPos(OldIndex) + Edit.PosDelta < Next.StartPos)
 				{
-					bIsHex = true;
+					OldIndex++;
 				}
-
-				token->Identifier[Length++] = c;
-				if (Length >= Token::NameSize)
+				if (OldIndex < Array.Num() && IsMovedToken(Array[OldIndex], Next, Edit.PosDelta))
 				{
-					SetError(Re::String{"Number length exceeds maximum of "} + std::to_string(Token::NameSize) + ": at " + GetLocation() );
-					Length = ((int32)Token::NameSize) - 1;
+					bResynced = true;
 					break;
 				}
+			}
+			NewTokens.push_back(Next);
+		}
 
-				c = static_cast<char>(std::toupper(GetChar()));
-			} while ((c >= '0' && c <= '9') || (!bIsFloat && c == '.') || (!bIsHex && c == 'X') || (bIsHex && c >= 'A' && c <= 'F'));
+		OutRelexEnd = InputPos;
+		if (!bResynced)
+		{
+			OldIndex = Array.Num();
+			PreTokenizedEndPos = InputPos;
+			// the lexer may have stepped back from the end, e.g. to an unterminated comment
+			OutRelexEnd = InputLen;
+		}
 
-			token->Identifier[Length] = 0;
-			if (!bIsFloat || c != 'F')
-			{
-				UngetChar();
-			}
+		Range.OldNum = OldIndex - Range.First;
+		Range.NewNum = static_cast<int32>(NewTokens.size());
+		Array.Replace(Range.First, OldIndex, NewTokens, Edit.PosDelta);
+		return Range;
+	}
 
-			if (bIsFloat)
-			{
-				token->SetConstFloat(std::atof(token->Identifier));
-			}
-			else if (bIsHex)
-			{
-				char* End = token->Identifier + std::strlen(token->Identifier);
-				token->SetConstInt64(std::strtoll(token->Identifier, &End, 0));
-			}
-			else
+	bool BaseParser::ReadPreTokenized(Token& OutToken, bool bNoConsts)
+	{
+		TokenArray& Array = bNoConsts ? NoConstTokens : ConstTokens;
+		const int32 Index = Array.Seek(InputPos);
+		if (Index > 0 && Array[Index - 1].GetEndPos() > InputPos)
+		{
+			// the cursor was left inside a token of this view by the other view, lex it directly
+			bPreTokenized = false;
+			const bool bResult = LexToken(OutToken, bNoConsts);
+			bPreTokenized = true;
+			return bResult;
+		}
+		if (Index == Array.Num())
+		{
+			InputPos = PrevPos = PreTokenizedEndPos;
+			return false;
+		}
+
+		OutToken = Array[Index];
+		// tokens kept across ApplyEdit may still point into the buffer before the edit
+		OutToken.Source = Input;
+		PrevPos = OutToken.StartPos;
+		InputPos = OutToken.GetEndPos();
+		return true;
+	}
+
+	Token BaseParser::GetPreToken(int32 Index) const
+	{
+		Token Result = ConstTokens[Index];
+		Result.Source = Input;
+		return Result;
+	}
+
+	void BaseParser::SetPreTokenCursor(int32 Index)
+	{
+		InputPos = Index < ConstTokens.Num() ? ConstTokens.GetStartPos(Index) : PreTokenizedEndPos;
+		PrevPos = InputPos;
+	}
+
+	bool BaseParser::LexToken(Token& OutToken, bool bNoConsts)
+	{
+		if (bPreTokenized)
+		{
+			return ReadPreTokenized(OutToken, bNoConsts);
+		}
+		if (Stream.IsOpen())
+		{
+			return LexStreamToken(OutToken, [this, bNoConsts](Token& StreamToken)
 			{
-				token->SetConstInt64(std::atoll(token->Identifier));
-			}
-			return token;
+				return TableLexer ? LexTableToken(StreamToken) : LexTokenWith<VirtualLexRules>(StreamToken, bNoConsts);
+			});
 		}
-		else if (c == '\'')
+		if (TableLexer)
 		{
-			char ActualCharLiteral = GetChar(/*bLiteral=*/ true);
+			return LexTableToken(OutToken);
+		}
+		return LexTokenWith<VirtualLexRules>(OutToken, bNoConsts);
+	}
 
-			bool IsUnicode = false;
-			char FrontChar = '?';
-			if (ActualCharLiteral == '\\')
+	bool BaseParser::LexTableToken(Token& OutToken)
+	{
+		while (InputPos < InputLen)
+		{
+			const int64 StartPos = InputPos;
+			int32 PatternIndex = -1;
+			int32 MatchLength = TableLexer->Match(Input, InputPos, InputLen, PatternIndex);
+			if (MatchLength == 0)
 			{
-				ActualCharLiteral = GetChar(/*bLiteral=*/ true);
-				switch (ActualCharLiteral)
-				{
-				case static_cast<char>('t'):
-					ActualCharLiteral = '\t';
-					break;
-				case static_cast<char>('n'):
-					ActualCharLiteral = '\n';
-					break;
-				case static_cast<char>('r'):
-					ActualCharLiteral = '\r';
-					break;
-				case static_cast<char>('u'):
-				case static_cast<char>('x'):
-				case static_cast<char>('U'):
-					IsUnicode = true;
-					FrontChar = ActualCharLiteral;
-					break;
-				}
+				Report(EDiagnosticCode::UnrecognizedChar, { Input[InputPos] });
+				PatternIndex = -1;
+				MatchLength = 1;
 			}
 
-			if(IsUnicode)
+			InputPos += MatchLength;
+			PrevPos = StartPos;
+			if (PatternIndex >= 0 && TableLexer->GetPattern(PatternIndex).Kind == ETokenPatternKind::Skip)
 			{
-				Re::String WS;
-				WS += FrontChar;
-				for(int i = 0; i < 4; i ++)
-				{
-					auto SubChar = GetChar(/*bLiteral=*/ true);
-					WS += SubChar;
-				}
-
-				c = GetChar(/*bLiteral=*/ true);
-				if (c != '\'')
-				{
-					SetError(Re::String{"Unterminated character constant : at "} + FileName + " : " + GetLocation());
-					UngetChar();
-				}
+				continue;
+			}
 
-				// TODO parse unicode char
-				RE_LOG(Re::String{"UnHandled Unicode Char : "} + WS);
-				token->SetConstChar(FrontChar);
+			OutToken.InitToken();
+			OutToken.Source = Input;
+			OutToken.StartPos = StartPos;
+			OutToken.Length = MatchLength;
+			if (PatternIndex >= 0)
+			{
+				TableLexer->ClassifyToken(OutToken, PatternIndex);
 			}
 			else
 			{
-				c = GetChar(/*bLiteral=*/ true);
-				if (c != '\'')
-				{
-					SetError(Re::String{"Unterminated character constant : at "} + FileName + " : " + GetLocation());
-					UngetChar();
-				}
-
+				OutToken.TokenType = ETokenType::Symbol;
 			}
-			token->SetConstChar(ActualCharLiteral);
-
-			return token;
-		}
-		else if (c == '"')
-		{
-			// String constant.
-			char Temp[Token::MaxStringConstSize];
-			int32 Length = 0;
-			c = GetChar(/*bLiteral=*/ true);
-			while ((c != '"') && !IsEOL(c))
+			if (OutToken.TokenType == ETokenType::Identifier)
 			{
-				if (c == '\\')
-				{
-					c = GetChar(/*bLiteral=*/ true);
-					if (IsEOL(c))
-					{
-						break;
-					}
-					else if (c == 'n')
-					{
-						// Newline escape sequence.
-						c = '\n';
-					}
-				}
-				Temp[Length++] = c;
-				if (Length >= Token::MaxStringConstSize)
+				if (Keywords)
 				{
-					SetError(Re::String{"String constant exceeds maximum of "} + std::to_string(Token::MaxStringConstSize) +
-						" characters : at " + FileName + " : " + GetLocation());
-					c = '\"';
-					Length = ((int32)Token::MaxStringConstSize) - 1;
-					break;
+					OutToken.Value.Identifier.KeywordId = Keywords->Find(OutToken.GetTokenView());
 				}
-				c = GetChar(/*bLiteral=*/ true);
-			}
-			Temp[Length] = 0;
-
-			if (c != '"')
-			{
-				SetError(Re::String{"Unterminated string constant: "} + Temp + " at " + FileName + " : " + GetLocation());
-				UngetChar();
-			}
-
-			token->SetConstString(Temp, Length);
-			return token;
-		}
-		else
-		{
-			// Symbol.
-			int32 Length = 0;
-			token->Identifier[Length++] = c;
-
-			// Handle special 2-character symbols.
-			#define PAIR(cc,dd) ((c==cc)&&(d==dd)) /* Comparison macro for convenience */
-			char d = GetChar();
-			if
-				(PAIR('<', '<')
-					|| (PAIR('>', '>'))
-					|| PAIR('!', '=')
-					|| PAIR('<', '=')
-					|| PAIR('>', '=')
-					|| PAIR('+', '+')
-					|| PAIR('-', '-')
-					|| PAIR('+', '=')
-					|| PAIR('-', '=')
-					|| PAIR('*', '=')
-					|| PAIR('/', '=')
-					|| PAIR('&', '&')
-					|| PAIR('|', '|')
-					|| PAIR('^', '^')
-					|| PAIR('=', '=')
-					|| PAIR('*', '*')
-					|| PAIR('~', '=')
-					|| PAIR(':', ':')
-					)
-			{
-				token->Identifier[Length++] = d;
-				if (c == '>' && d == '>')
+				if (Atoms)
 				{
-					if (GetChar() == '>')
-					{
-						token->Identifier[Length++] = '>';
-					}
-					else
-					{
-						UngetChar();
-					}
+					OutToken.Value.Identifier.AtomId = Atoms->Intern(OutToken.GetTokenView());
 				}
 			}
-			else
+			else if (OutToken.TokenType == ETokenType::Symbol)
 			{
-				UngetChar();
+				OutToken.Value.Symbol.SymbolId = Operators->Find(OutToken.GetTokenView());
+				if (Atoms)
+				{
+					OutToken.Value.Symbol.AtomId = Atoms->Intern(OutToken.GetTokenView());
+				}
 			}
-			#undef PAIR
-
-			token->Identifier[Length] = 0;
-			token->TokenType = ETokenType::Symbol;
-
-			return token;
+			return true;
 		}
+		PrevPos = InputPos;
+		return false;
 	}
 
-	Re::Vector<Re::SharedPtr<Token>> BaseParser::GetTokensUntil(Re::Func<bool(Token&)> Condition, bool bNoConst, const Re::String& DebugMessage)
+	Re::Vector<const Token*> BaseParser::GetTokensUntil(Re::Func<bool(const Token&)> Condition, bool bNoConst, const Re::String& DebugMessage)
 	{
-		Re::Vector<Re::SharedPtr<Token>> Tokens;
+		Re::Vector<const Token*> Tokens;
 		while(true)
 		{
 			auto CurrentToken = GetToken(bNoConst);
 
 			if(CurrentToken == nullptr)
 			{
-				SetError(Re::String{"Exit Early !! "} + DebugMessage + " at " + FileName + " : " + GetLocation());
+				Report(EDiagnosticCode::ExitEarly, { DebugMessage });
 				return Tokens;
 			}
 
@@ -523,16 +634,16 @@ namespace ReParser
 		return Tokens;
 	}
 
-	Re::Vector<Re::SharedPtr<Token>> BaseParser::GetTokenUntilMatch(const char Match, bool bNoConst, const Re::String& DebugMessage)
+	Re::Vector<const Token*> BaseParser::GetTokenUntilMatch(const char Match, bool bNoConst, const Re::String& DebugMessage)
 	{
-		Re::Vector<Re::SharedPtr<Token>> Tokens;
+		Re::Vector<const Token*> Tokens;
 		while (true)
 		{
 			auto CurrentToken = GetToken(bNoConst);
 
 			if(CurrentToken == nullptr)
 			{
-				SetError(Re::String{"Exit Early !! "} + DebugMessage + " at " + FileName + " : " + GetLocation());
+				Report(EDiagnosticCode::ExitEarly, { DebugMessage });
 				return Tokens;
 			}
 
@@ -547,15 +658,15 @@ namespace ReParser
 		return Tokens;
 	}
 
-	Re::Vector<Re::SharedPtr<Token>> BaseParser::GetTokenUntilMatch(const char* Match, bool bNoConst, const Re::String& DebugMessage)
+	Re::Vector<const Token*> BaseParser::GetTokenUntilMatch(const char* Match, bool bNoConst, const Re::String& DebugMessage)
 	{
-		Re::Vector<Re::SharedPtr<Token>> Tokens;
+		Re::Vector<const Token*> Tokens;
 		while (true)
 		{
 			auto CurrentToken = GetToken(bNoConst);
 			if(CurrentToken == nullptr)
 			{
-				SetError(Re::String{"Exit Early !! "} + DebugMessage + " : at " + FileName + " : " + GetLocation());
+				Report(EDiagnosticCode::ExitEarly, { DebugMessage });
 				return Tokens;
 			}
 
@@ -569,16 +680,16 @@ namespace ReParser
 
 		return Tokens;
 	}
-	Re::Vector<Re::SharedPtr<Token>> BaseParser::GetTokensUntilPairMatch(const char Left, const char Right, const Re::String& DebugMessage)
+	Re::Vector<const Token*> BaseParser::GetTokensUntilPairMatch(const char Left, const char Right, const Re::String& DebugMessage)
 	{
 		int MatchCount = 1;
-		Re::Vector<Re::SharedPtr<Token>> Tokens;
+		Re::Vector<const Token*> Tokens;
 		while(true)
 		{
 			auto CurrentToken = GetToken(false);
 			if(CurrentToken == nullptr)
 			{
-				SetError(Re::String{"Exit Early !! "} +  DebugMessage + " : at " + FileName + " : " + GetLocation());
+				Report(EDiagnosticCode::ExitEarly, { DebugMessage });
 				return Tokens;
 			}
 
@@ -603,23 +714,35 @@ namespace ReParser
     void BaseParser::UngetToken(const Token& Token)
     {
         InputPos = Token.StartPos;
-        InputLine = Token.StartLine;
     }
 
-    void BaseParser::UngetToken(const Re::SharedPtr<Token>& Token)
+    void BaseParser::UngetToken(const Token* Token)
 	{
 		InputPos = Token->StartPos;
-		InputLine = Token->StartLine;
 	}
 
     void BaseParser::ResetToToken(const Token& Token)
     {
     	UngetToken(Token);
-    	auto tempToken = GetToken();
-    	RE_ASSERT(Token == *tempToken);
+    	ReParser::Token tempToken;
+    	if (!LexToken(tempToken))
+    	{
+    		// the end token
+    		RE_ASSERT(Token.Length == 0);
+    		return;
+    	}
+    	RE_ASSERT(Token == tempToken);
     }
 
-    Re::SharedPtr<Token> BaseParser::GetIdentifier(bool bNoConsts)
+	Token BaseParser::GetEndToken() const
+	{
+		Token Result;
+		Result.Source = Input;
+		Result.StartPos = InputPos;
+		return Result;
+	}
+
+    const Token* BaseParser::GetIdentifier(bool bNoConsts)
 	{
 		auto Token = GetToken(bNoConsts);
 		if (!Token)
@@ -636,7 +759,7 @@ namespace ReParser
 		return nullptr;
 	}
 
-	Re::SharedPtr<Token> BaseParser::GetSymbol()
+	const Token* BaseParser::GetSymbol()
 	{
 		auto Token = GetToken();
 		if (!Token)
@@ -655,22 +778,22 @@ namespace ReParser
 
 	bool BaseParser::GetConstInt(int32& Result, const char* Tag)
 	{
-		auto Token = GetToken();
-		if(Token)
+		Token Next;
+		if(LexToken(Next))
 		{
-			if(Token->GetConstInt(Result))
+			if(Next.GetConstInt(Result))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 
 		if(Tag != nullptr)
 		{
-			SetError(Re::String{"Missing constant integer : "} + Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingConstInt, { Tag });
 		}
 
 		return false;
@@ -678,22 +801,22 @@ namespace ReParser
 
 	bool BaseParser::GetConstInt64(int64& Result, const char* Tag)
 	{
-		auto Token = GetToken();
-		if (Token)
+		Token Next;
+		if(LexToken(Next))
 		{
-			if (Token->GetConstInt64(Result))
+			if (Next.GetConstInt64(Result))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 
 		if (Tag != nullptr)
 		{
-			SetError(Re::String{"Missing constant integer : "} +  Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingConstInt, { Tag });
 		}
 
 		return false;
@@ -701,36 +824,80 @@ namespace ReParser
 
 	bool BaseParser::MatchIdentifier(const char* Match)
 	{
-		auto Token = GetToken();
-		if(Token != nullptr)
+		Token Next;
+		if(LexToken(Next))
+		{
+			if(Next.GetTokenType() == ETokenType::Identifier &&
+				Next.Matches(Match))
+			{
+				return true;
+			}
+			else
+			{
+				UngetToken(Next);
+			}
+		}
+		return false;
+	}
+
+	bool BaseParser::MatchAtom(int32 AtomId)
+	{
+		Token Next;
+		if(LexToken(Next, true))
+		{
+			if(AtomId != 0 && Next.GetAtomId() == AtomId)
+			{
+				return true;
+			}
+			else
+			{
+				UngetToken(Next);
+			}
+		}
+		return false;
+	}
+
+	bool BaseParser::MatchKeyword(int32 KeywordId)
+	{
+		Token Next;
+		if(LexToken(Next))
 		{
-			if(Token->GetTokenType() == ETokenType::Identifier &&
-				Token->Matches(Match))
+			if(KeywordId != 0 && Next.GetKeywordId() == KeywordId)
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 		return false;
 	}
 
+	// whether an integer constant token has the value written in Text, without formatting the token
+	static bool IsConstIntText(const Token& InToken, const char* Text)
+	{
+		int64 Expected = 0;
+		const char* TextEnd = Text + std::strlen(Text);
+		const auto [Ptr, Ec] = std::from_chars(Text, TextEnd, Expected);
+		int64 Actual = 0;
+		return Ec == std::errc{} && Ptr == TextEnd && InToken.GetConstInt64(Actual) && Actual == Expected;
+	}
+
 	bool BaseParser::MatchConstInt(const char* Match)
 	{
-		auto Token = GetToken();
-		if(Token)
+		Token Next;
+		if(LexToken(Next))
 		{
-			if(Token->GetTokenType() == ETokenType::Const
-				&& (Token->GetConstType() == ETokenConstType::Int || Token->GetConstType() == ETokenConstType::Int64)
-				&& Token->GetTokenName() == Match)
+			if(Next.GetTokenType() == ETokenType::Const
+				&& (Next.GetConstType() == ETokenConstType::Int || Next.GetConstType() == ETokenConstType::Int64)
+				&& IsConstIntText(Next, Match))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 
@@ -739,18 +906,18 @@ namespace ReParser
 
 	bool BaseParser::MatchAnyConstInt()
 	{
-		auto Token = GetToken();
-		if (Token)
+		Token Next;
+		if(LexToken(Next))
 		{
-			if (Token->GetTokenType() == ETokenType::Const
-				&& (Token->GetConstType() == ETokenConstType::Int
-					|| Token->GetConstType() == ETokenConstType::Int64))
+			if (Next.GetTokenType() == ETokenType::Const
+				&& (Next.GetConstType() == ETokenConstType::Int
+					|| Next.GetConstType() == ETokenConstType::Int64))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 
@@ -759,29 +926,32 @@ namespace ReParser
 
 	bool BaseParser::PeekIdentifier(const char* Match)
 	{
-		auto Token = GetToken(true);
-		if(!Token)
+		Token Next;
+		if(!LexToken(Next, true))
 		{
 			return false;
 		}
-		UngetToken(Token);
-		return Token->GetTokenType() == ETokenType::Identifier
-			&& Token->GetTokenName() == Match;
+		UngetToken(Next);
+		return Next.GetTokenType() == ETokenType::Identifier
+			&& Next.GetTokenView() == Match;
 	}
 
 	bool BaseParser::MatchSymbol(const char Match)
 	{
-		auto Token = GetToken(true);
-		if(Token)
+		return MatchSymbolId(static_cast<uint8>(Match));
+	}
+
+	bool BaseParser::MatchSymbolId(int32 SymbolId)
+	{
+		Token Next;
+		if(LexToken(Next, true))
 		{
-			if(Token->GetTokenType() == ETokenType::Symbol
-				&& Token->GetRawTokenName()[0] == Match
-				&& Token->GetRawTokenName()[1] == 0)
+			if(SymbolId != 0 && Next.GetSymbolId() == SymbolId)
 			{
 				return true;
 			}else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 		return false;
@@ -789,46 +959,48 @@ namespace ReParser
 
 	bool BaseParser::MatchSymbol(const char* Match)
 	{
-		auto Token = GetToken(true);
-		if (Token)
+		const int32 SymbolId = Operators->Find(Match);
+		Token Next;
+		if(LexToken(Next, true))
 		{
-			if (Token->GetTokenType() == ETokenType::Symbol
-				&& Token->GetTokenName() == Match)
+			// symbols the table does not know are only produced by a TableLexer, compare their text
+			if (Next.GetTokenType() == ETokenType::Symbol
+				&& (SymbolId != 0 ? Next.GetSymbolId() == SymbolId : Next.GetTokenView() == Match))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 		return false;
 	}
 
-	bool BaseParser::IsEndOfLine(int currentLine)
+	bool BaseParser::IsEndOfLine(int64 currentLine)
 	{
-    	auto token = GetToken();
-    	if(!token)
+    	Token Next;
+    	if(!LexToken(Next))
 		{
 			return true;
 		}
-    	auto newLine = InputLine;
-    	UngetToken(token);
+    	auto newLine = GetInputLine();
+    	UngetToken(Next);
     	return currentLine != newLine;
 	}
 
 	bool BaseParser::MatchToken(Re::Func<bool(const Token&)> Condition)
 	{
-		auto Token = GetToken(true);
-		if (Token)
+		Token Next;
+		if(LexToken(Next, true))
 		{
-			if (Condition(*Token))
+			if (Condition(Next))
 			{
 				return true;
 			}
 			else
 			{
-				UngetToken(Token);
+				UngetToken(Next);
 			}
 		}
 		return false;
@@ -847,15 +1019,15 @@ namespace ReParser
 	{
 		if(!MatchSymbol(';'))
 		{
-			auto Token = GetToken();
-			if(Token)
+			Token Next;
+			if(LexToken(Next))
 			{
-				SetError(Re::String{"Missing ';' before "} + Token->GetRawTokenName() + " : at " + GetLocation());
+				Report(EDiagnosticCode::MissingSemiBefore, { Next.GetTokenName() });
 				return false;
 			}
 			else
 			{
-				SetError(Re::String{"Missing ';'"} + " : at " + GetLocation());
+				Report(EDiagnosticCode::MissingSemi);
 				return false;
 			}
 		}
@@ -864,27 +1036,41 @@ namespace ReParser
 
 	Re::String BaseParser::GetLocation() const
 	{
-		return std::to_string(InputLine) + ":" + std::to_string(InputPos);
+		const SourceLocation Location = GetSourceLocation(InputPos);
+		return std::to_string(Location.Line) + ":" + std::to_string(Location.Column);
+	}
+
+	int64 BaseParser::GetLine(int64 Offset) const
+	{
+		return Lines.GetLine(Offset);
+	}
+
+	SourceLocation BaseParser::GetSourceLocation(int64 Offset) const
+	{
+		return Lines.GetLocation(Offset);
+	}
+
+	int64 BaseParser::GetInputLine() const
+	{
+		return Lines.GetLine(InputPos);
 	}
 
 	bool BaseParser::PeekSymbol(char Match)
 	{
-		auto Token = GetToken(true);
-		if(!Token)
+		Token Next;
+		if(!LexToken(Next, true))
 		{
 			return false;
 		}
-		UngetToken(Token);
-		return Token->GetTokenType() == ETokenType::Symbol
-			&& Token->GetRawTokenName()[0] == Match
-			&& Token->GetRawTokenName()[1] == 0;
+		UngetToken(Next);
+		return Next.GetSymbolId() == static_cast<uint8>(Match);
 	}
 
 	bool BaseParser::RequireIdentifier(const char* Match, const char* Tag)
 	{
 		if(!MatchIdentifier(Match))
 		{
-			SetError(Re::String{"Missing "} + Match + " in " + Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingSymbol, { Match, Tag });
 			return false;
 		}
 		return true;
@@ -894,7 +1080,7 @@ namespace ReParser
 	{
 		if(!MatchSymbol(Match))
 		{
-			SetError(Re::String{"Missing "} + Match + " in " + Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingSymbol, { Match, Tag });
 			return false;
 		}
 		return true;
@@ -904,7 +1090,7 @@ namespace ReParser
 	{
 		if(!MatchSymbol(Match))
 		{
-			SetError(Re::String{"Missing "} +  Match + " in " + TagGetter() + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingSymbol, { Match, TagGetter() });
 			return false;
 		}
 		return true;
@@ -914,7 +1100,7 @@ namespace ReParser
 	{
 		if(!MatchConstInt(Match))
 		{
-			SetError(Re::String{"Missing integer '"} + Match + "' in " + Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingInt, { Match, Tag });
 			return false;
 		}
 		return true;
@@ -924,7 +1110,7 @@ namespace ReParser
 	{
 		if(!MatchAnyConstInt())
 		{
-			SetError(Re::String{"Missing integer in "} + Tag + " : at " + GetLocation());
+			Report(EDiagnosticCode::MissingAnyInt, { Tag });
 			return false;
 		}
 		return true;
@@ -955,9 +1141,12 @@ namespace ReParser
 			file->OnNextToken(*this, *token);
 
 			CompileDeclaration(file, *token);
+			RecycleTokens();
 		}
 
 		PostParserProcess(file);
+		// the source may be released once parsed
+		Diagnostics.Locate(Lines);
 	}
 }
 
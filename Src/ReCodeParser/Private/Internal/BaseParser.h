@@ -3,6 +3,17 @@
 #include "ReClassInfo.h"
 #include "ReCppCommon.h"
 #include "Token.h"
+#include "TokenPool.h"
+#include "TokenArray.h"
+#include "CharClass.h"
+#include "LexPolicy.h"
+#include "DFALexer.h"
+#include "KeywordTable.h"
+#include "OperatorTable.h"
+#include "AtomTable.h"
+#include "LineIndex.h"
+#include "StreamSource.h"
+#include "Diagnostics.h"
 
 namespace ReParser
 {
@@ -23,10 +34,36 @@ namespace ReParser
 	{
         DECLARE_DERIVED_CLASS(ICodeFile, IParsableFile)
 	public:
-		virtual const Re::String& GetContent() const = 0;
+		/** Whole text of the file, it stays valid as long as the file. */
+		virtual std::string_view GetContent() const = 0;
 		virtual void OnNextToken(BaseParser& parser, const Token& token) { }
 	};
 
+	/** A file parsed in a batch, File is null when it could not be read, Error holds its formatted diagnostics. */
+	template <typename FileType>
+	struct FileParseResult
+	{
+		Re::SharedPtr<FileType> File;
+		Re::String Error;
+	};
+
+	/** Tokens replaced by an edit, [First, First + OldNum) of the old token stream became [First, First + NewNum). */
+	struct TokenEditRange
+	{
+		int32 First = 0;
+		int32 OldNum = 0;
+		int32 NewNum = 0;
+	};
+
+	/** A comment of the source with its delimiters, the line end after a line comment is not part of it. */
+	struct CommentSpan
+	{
+		int64 Offset = 0;
+		int64 Length = 0;
+
+		int64 GetEndPos() const { return Offset + Length; }
+	};
+
 	class RECODEPARSER_API BaseParser
 	{
 	public:
@@ -35,19 +72,98 @@ namespace ReParser
 
 		void InitParserSource(const char* SourceBuffer);
 
+		/** Subclasses hooking the source override this overload, it forwards the NUL-terminated buffer to the one below. */
 		virtual void InitParserSource(const Re::String& InFileName, const char* SourceBuffer);
 
+		/**
+		 * Parses SourceLength chars of SourceBuffer, the buffer needs no terminating NUL and may be larger than 2 GB.
+		 * Does not go through the virtual overload.
+		 */
+		void InitParserSource(const Re::String& InFileName, const char* SourceBuffer, int64 SourceLength);
+
+		/**
+		 * Parses a source read in chunks of ChunkSize while lexing, only the text from the first token
+		 * handed out since the last RecycleTokens on is kept, so tokens before it cannot be ungot anymore.
+		 * Pre-tokenization and ApplyEdit are not available on a streamed source.
+		 */
+		void InitParserStream(const Re::String& InFileName, StreamSource::ReaderFunc Reader, int64 ChunkSize = StreamSource::DefaultChunkSize);
+		void InitParserStream(const Re::String& InFileName, int FileDescriptor, int64 ChunkSize = StreamSource::DefaultChunkSize);
+
 		virtual bool ParseWithoutFile();
 
+		/**
+		 * Lexes the whole input once when the source is initialized, GetToken, UngetToken and
+		 * ResetToToken then only move a cursor over the token arrays instead of re-lexing.
+		 * Takes effect on the next InitParserSource call.
+		 */
+		void SetPreTokenize(bool bEnable) { bPreTokenize = bEnable; }
+		bool IsPreTokenized() const { return bPreTokenized; }
+
+		/**
+		 * Replaces RemovedLength chars at Offset by InsertedText in a pre-tokenized source, then re-lexes from
+		 * the last token before the edit until the tokens meet the old ones again, so the lexing cost follows
+		 * the edit size. The parser keeps its own copy of the edited text, the cursor returns to the start.
+		 *
+		 * @return false when the source is not pre-tokenized or the edit is out of range.
+		 */
+		bool ApplyEdit(int64 Offset, int64 RemovedLength, std::string_view InsertedText, TokenEditRange& OutRange);
+
+		/** Current input text, the edited one after ApplyEdit, the buffered part of a streamed source. */
+		std::string_view GetSource() const;
+
+		/** Lexes with the DFA compiled from token patterns instead of the built-in C-like rules, nullptr restores them. */
+		void SetTableLexer(const Re::SharedPtr<const DFALexer>& InLexer) { TableLexer = InLexer; }
+
+		/** Reserved words, identifiers lexed afterwards carry their keyword id. */
+		void SetKeywords(const Re::SharedPtr<const KeywordTable>& InKeywords) { Keywords = InKeywords; }
+		const KeywordTable* GetKeywords() const { return Keywords.get(); }
+
+		/** Multi-character operators lexed as one symbol, nullptr restores the default ones. */
+		void SetOperators(const Re::SharedPtr<const OperatorTable>& InOperators) { Operators = InOperators ? InOperators : OperatorTable::Default(); }
+		const OperatorTable& GetOperators() const { return *Operators; }
+
+		/** Interns identifiers and symbols lexed afterwards into InAtoms, nullptr stops interning. */
+		void SetAtoms(const Re::SharedPtr<AtomTable>& InAtoms) { Atoms = InAtoms; }
+		AtomTable* GetAtoms() const { return Atoms.get(); }
+
+		/** Records the span of every comment lexed afterwards, on by default. Comment text is only copied by GetDocComment. */
+		void SetCaptureComments(bool bEnable) { bCaptureComments = bEnable; }
+
+		/** Comments lexed so far in source order, a streamed source drops those before the text it keeps. */
+		const Re::Vector<CommentSpan>& GetComments() const { return Comments; }
+
+		/**
+		 * Text of the comments right before the token, from the first to the last one.
+		 * Comments apart by a blank line or a token do not belong to it.
+		 */
+		Re::String GetDocComment(const Token& InToken) const;
+
+		/** Diagnostics reported since the source was initialized, also sets their limit and abort policy. */
+		DiagnosticEngine& GetDiagnostics() { return Diagnostics; }
+		const DiagnosticEngine& GetDiagnostics() const { return Diagnostics; }
+		bool HasErrors() const { return Diagnostics.HasErrors(); }
+
 		virtual bool CompileDeclaration(const Token& token);
 		// Basic Operations
 
 		char GetChar(bool Literal = false);
-		char PeekChar();
+		char PeekChar() const { return (InputPos < InputLen) ? Input[InputPos] : 0; }
 		char GetLeadingChar();
 		void UngetChar();
+		/** Skips a run of default whitespace at once, returns the number of newlines skipped. */
+		int32 SkipWhitespaceRun();
+		/** Reports the first ill-formed UTF-8 sequence of the token. */
+		void ValidateUtf8(const Token& InToken);
+		/** Token::Length of a token spanning Length chars, one too long for it is reported and cut short. */
+		int32 ClampTokenLength(int64 Length);
+		/** Literal GetChar that first jumps over string literal chars without special meaning. */
+		char GetStringChar();
 
 		void SetError(const Re::String& str);
+		/** Reports a diagnostic at the current position, its message is only formatted by GetError. */
+		void Report(EDiagnosticCode Code, std::initializer_list<DiagnosticValue> Args = {}) { Diagnostics.Report(Code, InputPos, Args); }
+		void ReportAt(EDiagnosticCode Code, int64 Offset, std::initializer_list<DiagnosticValue> Args = {}) { Diagnostics.Report(Code, Offset, Args); }
+		/** Appends the formatted diagnostics to str, returns true if any error was reported. */
 		bool GetError(Re::String& str);
 
 		/**
@@ -70,9 +186,24 @@ namespace ReParser
 
 	protected:
 
-		/** Clears out the stored comment. */
+		/**
+		 * Replaces the character classification used by the lexer.
+		 * The table is not copied and must outlive the parser.
+		 */
+		void SetCharClassTable(const CharClassTable& Table);
+
+		/** Drops the recorded comments. */
 		void ClearComment();
 
+		void RecordComment(int64 Start, int64 End)
+		{
+			// a comment lexed again after a rewind is recorded already
+			if (bCaptureComments && (Comments.empty() || Comments.back().Offset < Start))
+			{
+				Comments.push_back({ Start, End - Start });
+			}
+		}
+
 	    virtual bool IsBeginComment(char currentChar)
 	    {
 	        auto nextChar = PeekChar();
@@ -100,21 +231,24 @@ namespace ReParser
 		/**
 		 * \brief
 		 * \param bNoConsts ignore Const
-		 * \return
+		 * \return next token or nullptr at the end of input, the token lives in the parser token pool
+		 * and stays valid until the pool is recycled after the current declaration
 		 */
-		Re::SharedPtr<Token> GetToken(bool bNoConsts = false);
+		const Token* GetToken(bool bNoConsts = false);
 
-		Re::Vector<Re::SharedPtr<Token>> GetTokensUntil(Re::Func<bool(Token&)> Condition, bool bNoConst = false, const Re::String& DebugMessage = "");
-		Re::Vector<Re::SharedPtr<Token>> GetTokenUntilMatch(const char Match, bool bNoConst = false, const Re::String& DebugMessage = "");
-		Re::Vector<Re::SharedPtr<Token>> GetTokenUntilMatch(const char* Match, bool bNoConst = false, const Re::String& DebugMessage = "");
-		Re::Vector<Re::SharedPtr<Token>> GetTokensUntilPairMatch(const char Left, const char Right, const Re::String& DebugMessage = "");
+		Re::Vector<const Token*> GetTokensUntil(Re::Func<bool(const Token&)> Condition, bool bNoConst = false, const Re::String& DebugMessage = "");
+		Re::Vector<const Token*> GetTokenUntilMatch(const char Match, bool bNoConst = false, const Re::String& DebugMessage = "");
+		Re::Vector<const Token*> GetTokenUntilMatch(const char* Match, bool bNoConst = false, const Re::String& DebugMessage = "");
+		Re::Vector<const Token*> GetTokensUntilPairMatch(const char Left, const char Right, const Re::String& DebugMessage = "");
 
         void UngetToken(const Token& Token);
-		void UngetToken(const Re::SharedPtr<Token>& Token);
+		void UngetToken(const Token* Token);
 		void ResetToToken(const Token& Token);
+		/** Zero-length token of no type at the current position, stands for the end of the input. */
+		Token GetEndToken() const;
 
-		Re::SharedPtr<Token>  GetIdentifier(bool bNoConsts = false);
-		Re::SharedPtr<Token> GetSymbol();
+		const Token* GetIdentifier(bool bNoConsts = false);
+		const Token* GetSymbol();
 
 		// TODO
 		bool GetConstInt(int32& Result, const char* Tag = NULL);
@@ -122,12 +256,15 @@ namespace ReParser
 
 		// Matching predefined text.
 		bool MatchIdentifier(const char* Match);
+		bool MatchKeyword(int32 KeywordId);
+		bool MatchAtom(int32 AtomId);
 		bool MatchConstInt(const char* Match);
 		bool MatchAnyConstInt();
 		bool PeekIdentifier(const char* Match);
 		bool MatchSymbol(const char Match);
 		bool MatchSymbol(const char* Match);
-		bool IsEndOfLine(int currentLine);
+		bool MatchSymbolId(int32 SymbolId);
+		bool IsEndOfLine(int64 currentLine);
 		bool MatchToken(Re::Func<bool(const Token&)> Condition);
 		bool MatchSemi();
 		bool PeekSymbol(char Match);
@@ -142,25 +279,122 @@ namespace ReParser
 
 	public:
 
+		/** Line and column of the current position. */
 		Re::String GetLocation() const;
 
+		/** Line of a source offset, lines are only counted when asked for. */
+		int64 GetLine(int64 Offset) const;
+		SourceLocation GetSourceLocation(int64 Offset) const;
+
 
 	protected:
 
+		/**
+		 * Lexes the next token into OutToken without touching the token pool.
+		 *
+		 * @return false at the end of input.
+		 */
+		virtual bool LexToken(Token& OutToken, bool bNoConsts = false);
+
+		/** Lexes the next token with TableLexer, skip patterns are consumed silently. */
+		bool LexTableToken(Token& OutToken);
+
+		/** Lexer core, Rules supplies comments, char classes, escapes and keywords as static functions. */
+		template <typename Rules>
+		char GetCharWith(bool bLiteral = false);
+		template <typename Rules>
+		char GetLeadingCharWith();
+		template <typename Rules>
+		char GetStringCharWith();
+		template <typename Rules>
+		void LexHexEscapeWith(char Letter);
+		template <typename Rules>
+		bool LexTokenWith(Token& OutToken, bool bNoConsts);
+
+		/** Rules that go through the comment virtuals and the char class table. */
+		struct VirtualLexRules
+		{
+			static bool IsBeginComment(BaseParser& Parser, char c) { return Parser.IsBeginComment(c); }
+			static bool IsEndComment(BaseParser& Parser, char c) { return Parser.IsEndComment(c); }
+			static bool IsLineComment(BaseParser& Parser, char c) { return Parser.IsLineComment(c); }
+			static const CharClassTable& Classes(const BaseParser& Parser) { return *Parser.CharClasses; }
+			static bool UseScanKernels(const BaseParser& Parser) { return Parser.bScanKernels; }
+			static constexpr bool BackslashEscapes() { return DefaultLexPolicy::bBackslashEscapes; }
+			static void LexKeyword(Token& InToken) { DefaultLexPolicy::LexKeyword(InToken); }
+		};
+
+		/** Rules resolved at compile time from a lex policy, see DefaultLexPolicy. */
+		template <typename LexPolicy>
+		struct PolicyLexRules
+		{
+			static bool IsBeginComment(const BaseParser& Parser, char c) { return LexPolicy::IsBeginComment(c, Parser.PeekChar()); }
+			static bool IsEndComment(const BaseParser& Parser, char c) { return LexPolicy::IsEndComment(c, Parser.PeekChar()); }
+			static bool IsLineComment(const BaseParser& Parser, char c) { return LexPolicy::IsLineComment(c, Parser.PeekChar()); }
+			static constexpr const CharClassTable& Classes(const BaseParser&) { return LexPolicy::Classes; }
+			static constexpr bool UseScanKernels(const BaseParser&) { return LexPolicy::bScanKernels; }
+			static constexpr bool BackslashEscapes() { return LexPolicy::bBackslashEscapes; }
+			static void LexKeyword(Token& InToken) { LexPolicy::LexKeyword(InToken); }
+		};
+
+		/** Recycles every token handed out by GetToken so far. */
+		void RecycleTokens();
+
+		/** Fills the const and no-const token arrays from the whole input. */
+		void PreTokenize();
+
+		struct TextEdit
+		{
+			int64 Offset = 0;
+			// end of the removed text in the old input
+			int64 OldEnd = 0;
+			// end of the inserted text in the new input
+			int64 NewEnd = 0;
+			int64 PosDelta = 0;
+		};
+
+		/**
+		 * Re-lexes the part of one pre-tokenized view an edit touched, the input already holds the new text.
+		 * OutRelexEnd receives the end of the re-lexed text.
+		 */
+		TokenEditRange RelexEdit(TokenArray& Array, bool bNoConsts, const TextEdit& Edit, int64& OutRelexEnd);
+
+		/** Reads the token at the current position from the pre-tokenized arrays. */
+		bool ReadPreTokenized(Token& OutToken, bool bNoConsts);
+
+		/** Const view of a pre-tokenized input read by index, for parsers walking the tokens themselves. */
+		int32 GetPreTokenNum() const { return ConstTokens.Num(); }
+		Token GetPreToken(int32 Index) const;
+		/** Index of the first pre-token at or after the current position. */
+		int32 GetPreTokenCursor() const { return ConstTokens.LowerBound(InputPos); }
+		/** Index of a token read from the pre-tokenized input, GetPreTokenNum() for the end token. */
+		int32 GetPreTokenIndex(const Token& InToken) const { return ConstTokens.LowerBound(InToken.GetStartPos()); }
+		/** Moves the current position in front of the pre-token at Index, the end of the input at GetPreTokenNum(). */
+		void SetPreTokenCursor(int32 Index);
+
+		/** Lexes a token of the streamed source with Lex, again with more text when it reaches the end of what was read. */
+		template <typename LexFunc>
+		bool LexStreamToken(Token& OutToken, LexFunc&& Lex);
+
+		/** Reads the streamed source up to MinEnd. */
+		void FillStream(int64 MinEnd);
+		void StartStream(const Re::String& InFileName);
+
+		/** Line of the current position. */
+		int64 GetInputLine() const;
+
 		// Input text
 		const char* Input = nullptr;
 		// Length of input text
-		int32 InputLen = 0;
+		int64 InputLen = 0;
 		// Current position in text
-		int32 InputPos = 0;
-		// Current line in text
-		int32 InputLine = 0;
-		// last GetChar line
-		int32 PrevPos = 0;
+		int64 InputPos = 0;
 		// last GetChar pos
-		int32 PrevLine = 0;
-		// Previous comment parsed by GetChar() call.
-		Re::String PrevComment;
+		int64 PrevPos = 0;
+		// Line starts of the input, built when a line is asked for
+		mutable LineIndex Lines;
+		// Comments lexed so far, in source order
+		Re::Vector<CommentSpan> Comments;
+		bool bCaptureComments = true;
 		// Number of statements parsed.
 		int32 StatementsParsed = 0;
 		// Total number of lines parsed.
@@ -168,7 +402,42 @@ namespace ReParser
 
 		Re::String FileName;
 
-		Re::Vector<Re::String> Errors;
+		DiagnosticEngine Diagnostics;
+
+		// Character classification used by the lexer
+		const CharClassTable* CharClasses = &CharClassTable::Default();
+		// Lex with the SIMD scan kernels, only valid for the default classes
+		bool bScanKernels = true;
+
+		// Lexer compiled from token patterns, replaces the built-in rules when set
+		Re::SharedPtr<const DFALexer> TableLexer;
+
+		// Reserved words of this parser
+		Re::SharedPtr<const KeywordTable> Keywords;
+
+		// Operators of this parser, symbol ids of symbol tokens come from it
+		Re::SharedPtr<const OperatorTable> Operators = OperatorTable::Default();
+
+		// Interner giving identifiers and symbols their atom, none by default
+		Re::SharedPtr<AtomTable> Atoms;
+
+		// Storage of the tokens handed out by GetToken
+		TokenPool Tokens;
+
+		bool bPreTokenize = false;
+		bool bPreTokenized = false;
+		// Pre-tokenized input, seen with and without const values
+		TokenArray ConstTokens;
+		TokenArray NoConstTokens;
+		// Position after the last token of the pre-tokenized input
+		int64 PreTokenizedEndPos = 0;
+		// Own copy of the input once ApplyEdit changed it
+		Re::String EditedSource;
+
+		// Chunked source of InitParserStream, Input is its window then
+		StreamSource Stream;
+		// Text before it is not needed by the tokens alive anymore
+		int64 StreamKeepPos = 0;
 	};
 
 	class BaseParserWithFile : public BaseParser
@@ -204,4 +473,42 @@ namespace ReParser
 		}
 	};
 
+	/**
+	 * Parser whose lexing rules are fixed at compile time by LexPolicy (see DefaultLexPolicy),
+	 * so the whole lexer loop is inlined instead of calling the comment virtuals per character.
+	 * The comment virtuals are overridden from the policy and stay consistent for GetChar callers.
+	 */
+	template <typename LexPolicy, typename ParserBase = BaseParser>
+	class TBaseParser : public ParserBase
+	{
+	public:
+		TBaseParser()
+		{
+			this->SetCharClassTable(LexPolicy::Classes);
+			this->bScanKernels = LexPolicy::bScanKernels;
+		}
+
+	protected:
+		bool IsBeginComment(char currentChar) final { return LexPolicy::IsBeginComment(currentChar, this->PeekChar()); }
+		bool IsEndComment(char currentChar) final { return LexPolicy::IsEndComment(currentChar, this->PeekChar()); }
+		bool IsLineComment(char currentChar) final { return LexPolicy::IsLineComment(currentChar, this->PeekChar()); }
+
+		bool LexToken(Token& OutToken, bool bNoConsts = false) override
+		{
+			if (this->bPreTokenized)
+			{
+				return this->ReadPreTokenized(OutToken, bNoConsts);
+			}
+			if (this->Stream.IsOpen())
+			{
+				return this->LexStreamToken(OutToken, [this, bNoConsts](Token& StreamToken)
+				{
+					return this->template LexTokenWith<BaseParser::PolicyLexRules<LexPolicy>>(StreamToken, bNoConsts);
+				});
+			}
+			return this->template LexTokenWith<BaseParser::PolicyLexRules<LexPolicy>>(OutToken, bNoConsts);
+		}
+	};
 }
+
+#include "BaseParser.tpp"
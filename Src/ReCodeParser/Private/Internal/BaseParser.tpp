@@ -0,0 +1,353 @@
+#pragma once
+#include <algorithm>
+#include "BaseParser.h"
+#include "ScanKernels.h"
+#include "NumberScan.h"
+
+// Lexer core shared by BaseParser and TBaseParser, Rules decides comments, char classes and keywords.
+namespace ReParser
+{
+	template <typename Rules>
+	char BaseParser::GetCharWith(bool bLiteral)
+	{
+		bool bInsideComment = false;
+		int64 CommentStart = 0;
+
+		PrevPos = InputPos;
+
+	Loop:
+		// the input needs no terminating NUL, its end reads as one
+		const char c = InputPos < InputLen ? Input[InputPos] : 0;
+		InputPos++;
+
+		if (c != '\n' && !bLiteral)
+		{
+			if (Rules::IsBeginComment(*this, c))
+			{
+				if (!bInsideComment)
+				{
+					CommentStart = InputPos - 1;
+					bInsideComment = true;
+
+					// Move past the star. Do it only when not in comment,
+					// otherwise end of comment might be missed e.g.
+					// /*/ Comment /*/
+					// ~~~~~~~~~~~~~^ Will report second /* as beginning of comment
+					// And throw error that end of file is found in comment.
+					InputPos++;
+				}
+
+				goto Loop;
+			}
+			else if (Rules::IsEndComment(*this, c))
+			{
+				if (!bInsideComment)
+				{
+					Report(EDiagnosticCode::UnexpectedCommentEnd);
+				}
+				else
+				{
+					RecordComment(CommentStart, InputPos + 1);
+				}
+
+				/** Asterisk and slash always end comment. */
+				bInsideComment = false;
+
+				// Move past the slash.
+				InputPos++;
+				goto Loop;
+			}
+		}
+
+		if (bInsideComment)
+		{
+			if (c == 0)
+			{
+				Report(EDiagnosticCode::UnterminatedComment);
+				// the input ends here, an unterminated comment is common while a source is being edited
+				return c;
+			}
+			goto Loop;
+		}
+		return c;
+	}
+
+	template <typename Rules>
+	char BaseParser::GetLeadingCharWith()
+	{
+		for (;;)
+		{
+			char c;
+
+			// Skip blanks.
+			do
+			{
+				if (Rules::UseScanKernels(*this))
+				{
+					SkipWhitespaceRun();
+				}
+				c = GetCharWith<Rules>();
+			} while (Rules::Classes(*this).IsWhitespace(c));
+
+			if (!Rules::IsLineComment(*this, c))
+			{
+				return c;
+			}
+
+			const int64 CommentStart = InputPos - 1;
+			if (Rules::UseScanKernels(*this))
+			{
+				InputPos = Scan::FindLineEnd(Input + InputPos, Input + InputLen) - Input;
+			}
+
+			do
+			{
+				c = GetCharWith<Rules>(true);
+			} while (!Rules::Classes(*this).IsEOL(c));
+
+			// the line end, or the end of input read as NUL, is not part of the comment
+			RecordComment(CommentStart, InputPos - 1);
+			if (c == 0)
+			{
+				return c;
+			}
+		}
+	}
+
+	template <typename Rules>
+	char BaseParser::GetStringCharWith()
+	{
+		if (Rules::UseScanKernels(*this))
+		{
+			InputPos = Scan::FindStringStop(Input + InputPos, Input + InputLen) - Input;
+		}
+		return GetCharWith<Rules>(/*bLiteral=*/ true);
+	}
+
+	template <typename Rules>
+	void BaseParser::LexHexEscapeWith(char Letter)
+	{
+		// \xNN is a byte, \uXXXX and \UXXXXXXXX are code points GetConstantValue stores as UTF-8
+		const int32 MaxDigits = Letter == 'x' ? 2 : Letter == 'u' ? 4 : Letter == 'U' ? 8 : 0;
+		if (MaxDigits == 0)
+		{
+			return;
+		}
+		const int64 EscapeStart = InputPos - 2;
+		uint32 Value = 0;
+		int32 Digits = 0;
+		for (; Digits < MaxDigits && Rules::Classes(*this).IsHex(PeekChar()); Digits++)
+		{
+			const char Digit = GetCharWith<Rules>(/*bLiteral=*/ true);
+			Value = Value * 16 + static_cast<uint32>(Digit <= '9' ? Digit - '0' : (Digit | 0x20) - 'a' + 10);
+		}
+		const bool bCodePoint = Letter != 'x';
+		if (Digits == 0 || (bCodePoint && (Digits != MaxDigits || Value > 0x10FFFF || (Value >= 0xD800 && Value <= 0xDFFF))))
+		{
+			Report(EDiagnosticCode::InvalidEscape, { std::string_view(Input + EscapeStart, static_cast<size_t>(InputPos - EscapeStart)) });
+		}
+	}
+
+	template <typename Rules>
+	bool BaseParser::LexTokenWith(Token& OutToken, bool bNoConsts)
+	{
+		char c = GetLeadingCharWith<Rules>();
+		if (c == 0)
+		{
+			UngetChar();
+			return false;
+		}
+
+		Token* token = &OutToken;
+		token->InitToken();
+		token->Source = Input;
+		// c was read last, PrevPos stays at the start of a block comment GetChar skipped before it
+		token->StartPos = InputPos - 1;
+
+		char p = PeekChar();
+		if(Rules::Classes(*this).IsIdentifierStart(c))
+		{
+			// pure ASCII identifiers skip the UTF-8 validation
+			bool bNonAscii = static_cast<uint8>(c) >= 0x80;
+			if (Rules::UseScanKernels(*this))
+			{
+				InputPos = Scan::FindIdentifierEnd(Input + InputPos, Input + InputLen, bNonAscii) - Input;
+				PrevPos = InputPos;
+			}
+			else
+			{
+				do
+				{
+					c = GetCharWith<Rules>();
+					bNonAscii |= static_cast<uint8>(c) >= 0x80;
+				} while (Rules::Classes(*this).IsIdentifierPart(c));
+				UngetChar();
+			}
+			token->Length = ClampTokenLength(InputPos - token->StartPos);
+			if (bNonAscii)
+			{
+				ValidateUtf8(*token);
+			}
+			// Assume this is an identifier unless we find otherwise.
+			token->TokenType = ETokenType::Identifier;
+
+			if(!bNoConsts)
+			{
+				Rules::LexKeyword(*token);
+			}
+			if (token->TokenType == ETokenType::Identifier)
+			{
+				if (Keywords)
+				{
+					token->Value.Identifier.KeywordId = Keywords->Find(token->GetTokenView());
+				}
+				if (Atoms)
+				{
+					token->Value.Identifier.AtomId = Atoms->Intern(token->GetTokenView());
+				}
+			}
+			return true;
+		}
+		// if const values are allowed, determine whether the non-identifier token represents a const
+		else if (!bNoConsts && (Rules::Classes(*this).IsDigit(c) || ((c == '+' || c == '-') && Rules::Classes(*this).IsDigit(p))))
+		{
+			// Integer or floating point constant, scanned in place from its first char.
+			int64 Length = 0;
+			if (ScanNumber(Input + token->StartPos, Input + InputLen, *token, Length) == ENumberScanResult::OutOfRange)
+			{
+				Report(EDiagnosticCode::NumberOutOfRange, { std::string_view(Input + token->StartPos, static_cast<size_t>(Length)) });
+			}
+			token->Length = ClampTokenLength(Length);
+			InputPos = token->StartPos + Length;
+			PrevPos = InputPos - 1;
+			return true;
+		}
+		else if (c == '\'')
+		{
+			char ActualCharLiteral = GetCharWith<Rules>(/*bLiteral=*/ true);
+			if (Rules::BackslashEscapes() && ActualCharLiteral == '\\')
+			{
+				ActualCharLiteral = GetCharWith<Rules>(/*bLiteral=*/ true);
+				LexHexEscapeWith<Rules>(ActualCharLiteral);
+			}
+			else if (static_cast<uint8>(ActualCharLiteral) >= 0x80)
+			{
+				// the continuation bytes of a UTF-8 char, ValidateUtf8 checks the sequence
+				while ((static_cast<uint8>(PeekChar()) & 0xC0) == 0x80)
+				{
+					GetCharWith<Rules>(/*bLiteral=*/ true);
+				}
+			}
+
+			if (ActualCharLiteral == 0)
+			{
+				// the input ends inside the constant, as it often does while a source is being edited
+				UngetChar();
+			}
+
+			const int64 BodyLength = InputPos - token->StartPos - 1;
+			const bool bAtEnd = InputPos >= InputLen;
+			c = bAtEnd ? 0 : GetCharWith<Rules>(/*bLiteral=*/ true);
+			if (c != '\'')
+			{
+				Report(EDiagnosticCode::UnterminatedChar);
+				if (!bAtEnd)
+				{
+					UngetChar();
+				}
+			}
+			token->Length = ClampTokenLength(InputPos - token->StartPos);
+			// the body of a token cut short ends with it
+			token->SetConstString(static_cast<int32>(std::min<int64>(BodyLength, token->Length - 1)));
+			ValidateUtf8(*token);
+
+			return true;
+		}
+		else if (c == '"')
+		{
+			// String constant.
+			c = GetStringCharWith<Rules>();
+			while ((c != '"') && !Rules::Classes(*this).IsEOL(c))
+			{
+				if (Rules::BackslashEscapes() && c == '\\')
+				{
+					c = GetCharWith<Rules>(/*bLiteral=*/ true);
+					if (Rules::Classes(*this).IsEOL(c))
+					{
+						break;
+					}
+					LexHexEscapeWith<Rules>(c);
+				}
+				c = GetStringCharWith<Rules>();
+			}
+			// the closing quote or the EOL char is not part of the body
+			const int64 BodyLength = PrevPos - token->StartPos - 1;
+
+			if (c != '"')
+			{
+				Report(EDiagnosticCode::UnterminatedString, { std::string_view(Input + token->StartPos + 1, static_cast<size_t>(BodyLength)) });
+				UngetChar();
+			}
+
+			token->Length = ClampTokenLength(InputPos - token->StartPos);
+			// the body of a token cut short ends with it
+			token->SetConstString(static_cast<int32>(std::min<int64>(BodyLength, token->Length - 1)));
+			ValidateUtf8(*token);
+			return true;
+		}
+		else
+		{
+			// Symbol.
+
+			// longest operator of the table, the char itself when none starts here
+			int32 SymbolLength = 1;
+			token->Value.Symbol.SymbolId = Operators->Match(Input, token->StartPos, InputLen, SymbolLength);
+			if (SymbolLength > 1)
+			{
+				InputPos = token->StartPos + SymbolLength;
+				PrevPos = InputPos - 1;
+			}
+			if (Atoms)
+			{
+				token->Value.Symbol.AtomId = Atoms->Intern(std::string_view{ Input + token->StartPos, static_cast<size_t>(SymbolLength) });
+			}
+
+			token->Length = static_cast<int32>(InputPos - token->StartPos);
+			token->TokenType = ETokenType::Symbol;
+
+			return true;
+		}
+	}
+
+	template <typename LexFunc>
+	bool BaseParser::LexStreamToken(Token& OutToken, LexFunc&& Lex)
+	{
+		// the lexer looks at most a chunk past the end of a token and never less than a short constant or operator,
+		// enough is read ahead that most tokens end before that
+		const int64 Margin = std::max<int64>(Stream.GetChunkSize(), 64);
+		int64 Lookahead = Margin * 2;
+		for (;;)
+		{
+			if (!Stream.IsAtEnd() && InputLen - InputPos < Lookahead)
+			{
+				FillStream(InputPos + Lookahead);
+			}
+			const int64 StartPos = InputPos;
+			const int64 StartPrevPos = PrevPos;
+			const DiagnosticEngine::Mark DiagnosticMark = Diagnostics.GetMark();
+			const size_t CommentCount = Comments.size();
+			const bool bResult = Lex(OutToken);
+			if (Stream.IsAtEnd() || (bResult && InputLen - InputPos >= Margin))
+			{
+				return bResult;
+			}
+
+			// the token or a comment before it may go on in text not read yet, lex it again with more
+			InputPos = StartPos;
+			PrevPos = StartPrevPos;
+			Diagnostics.Rewind(DiagnosticMark);
+			Comments.resize(CommentCount);
+			Lookahead = (InputLen - StartPos + Margin) * 2;
+		}
+	}
+}
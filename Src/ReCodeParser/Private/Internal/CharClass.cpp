@@ -0,0 +1,10 @@
+#include "CharClass.h"
+
+namespace ReParser
+{
+	const CharClassTable& CharClassTable::Default()
+	{
+		static const CharClassTable Table = MakeDefault();
+		return Table;
+	}
+}
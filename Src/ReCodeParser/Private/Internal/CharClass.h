@@ -0,0 +1,101 @@
+#pragma once
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	enum class ECharClass : uint8
+	{
+		None = 0,
+		IdentifierStart = 1 << 0,
+		IdentifierPart = 1 << 1,
+		Digit = 1 << 2,
+		Hex = 1 << 3,
+		Whitespace = 1 << 4,
+		EOL = 1 << 5,
+	};
+
+	/**
+	 * 256-entry character classification used by every lexing path of BaseParser.
+	 * Parsers copy the default table and adjust it to change what the lexer accepts.
+	 */
+	class RECODEPARSER_API CharClassTable
+	{
+	public:
+		constexpr CharClassTable() = default;
+
+		/** C-like classification the lexer has always used. */
+		static const CharClassTable& Default();
+
+		/** Builds the default classification, usable in constant expressions. */
+		static constexpr CharClassTable MakeDefault()
+		{
+			CharClassTable Table;
+			Table.AddRange('A', 'Z', ECharClass::IdentifierStart);
+			Table.AddRange('a', 'z', ECharClass::IdentifierStart);
+			Table.Add('_', ECharClass::IdentifierStart);
+			// the bytes of UTF-8 chars, the lexer validates the sequences
+			Table.AddRange('\x80', '\xFF', ECharClass::IdentifierStart);
+
+			Table.AddRange('A', 'Z', ECharClass::IdentifierPart);
+			Table.AddRange('a', 'z', ECharClass::IdentifierPart);
+			Table.AddRange('0', '9', ECharClass::IdentifierPart);
+			Table.Add('_', ECharClass::IdentifierPart);
+			Table.AddRange('\x80', '\xFF', ECharClass::IdentifierPart);
+
+			Table.AddRange('0', '9', ECharClass::Digit);
+
+			Table.AddRange('0', '9', ECharClass::Hex);
+			Table.AddRange('A', 'F', ECharClass::Hex);
+			Table.AddRange('a', 'f', ECharClass::Hex);
+
+			Table.AddAll(" \t\r\n", ECharClass::Whitespace);
+
+			Table.AddAll("\r\n", ECharClass::EOL);
+			Table.Add('\0', ECharClass::EOL);
+
+			return Table;
+		}
+
+		constexpr bool Is(char c, ECharClass Class) const
+		{
+			return (Classes[static_cast<uint8>(c)] & static_cast<uint8>(Class)) != 0;
+		}
+
+		constexpr bool IsIdentifierStart(char c) const { return Is(c, ECharClass::IdentifierStart); }
+		constexpr bool IsIdentifierPart(char c) const { return Is(c, ECharClass::IdentifierPart); }
+		constexpr bool IsDigit(char c) const { return Is(c, ECharClass::Digit); }
+		constexpr bool IsHex(char c) const { return Is(c, ECharClass::Hex); }
+		constexpr bool IsWhitespace(char c) const { return Is(c, ECharClass::Whitespace); }
+		constexpr bool IsEOL(char c) const { return Is(c, ECharClass::EOL); }
+
+		constexpr void Add(char c, ECharClass Class)
+		{
+			Classes[static_cast<uint8>(c)] |= static_cast<uint8>(Class);
+		}
+
+		constexpr void Remove(char c, ECharClass Class)
+		{
+			Classes[static_cast<uint8>(c)] &= static_cast<uint8>(~static_cast<uint8>(Class));
+		}
+
+		constexpr void AddRange(char First, char Last, ECharClass Class)
+		{
+			for (int32 c = static_cast<uint8>(First); c <= static_cast<uint8>(Last); c++)
+			{
+				Add(static_cast<char>(c), Class);
+			}
+		}
+
+		constexpr void AddAll(const char* Chars, ECharClass Class)
+		{
+			for (; *Chars; Chars++)
+			{
+				Add(*Chars, Class);
+			}
+		}
+
+	private:
+		uint8 Classes[256] = {};
+	};
+}
@@ -0,0 +1,537 @@
+#include "DFALexer.h"
+
+#include <algorithm>
+#include <bitset>
+
+#include "NumberScan.h"
+#include "Token.h"
+
+namespace ReParser
+{
+	namespace
+	{
+		using CharSet = std::bitset<256>;
+
+		struct NFAState
+		{
+			Re::Vector<int32> Epsilon;
+			// chars moving to Next
+			CharSet Chars;
+			int32 Next = -1;
+			int32 Accept = -1;
+		};
+
+		struct Fragment
+		{
+			int32 Start = -1;
+			int32 End = -1;
+		};
+
+		// Thompson construction of one pattern into the shared NFA
+		class RegexCompiler
+		{
+		public:
+			RegexCompiler(Re::Vector<NFAState>& InStates, const Re::String& InPattern)
+				: States(InStates)
+				, Pattern(InPattern)
+			{
+			}
+
+			bool Compile(Fragment& OutFragment, Re::String& OutError)
+			{
+				OutFragment = ParseAlternation();
+				if (Error.empty() && Pos < Pattern.size())
+				{
+					Error = "unbalanced ')'";
+				}
+				if (!Error.empty())
+				{
+					OutError = RE_FORMAT("%s at %d in \"%s\"", Error.c_str(), static_cast<int32>(Pos), Pattern.c_str());
+					return false;
+				}
+				return true;
+			}
+
+		private:
+			int32 NewState()
+			{
+				States.emplace_back();
+				return static_cast<int32>(States.size()) - 1;
+			}
+
+			Fragment MakeEmpty()
+			{
+				Fragment Result{ NewState(), NewState() };
+				States[Result.Start].Epsilon.push_back(Result.End);
+				return Result;
+			}
+
+			Fragment MakeChars(const CharSet& Chars)
+			{
+				Fragment Result{ NewState(), NewState() };
+				States[Result.Start].Chars = Chars;
+				States[Result.Start].Next = Result.End;
+				return Result;
+			}
+
+			bool AtEnd() const { return Pos >= Pattern.size(); }
+
+			Fragment ParseAlternation()
+			{
+				Fragment Left = ParseSequence();
+				while (Error.empty() && !AtEnd() && Pattern[Pos] == '|')
+				{
+					Pos++;
+					const Fragment Right = ParseSequence();
+					const Fragment Joined{ NewState(), NewState() };
+					States[Joined.Start].Epsilon.push_back(Left.Start);
+					States[Joined.Start].Epsilon.push_back(Right.Start);
+					States[Left.End].Epsilon.push_back(Joined.End);
+					States[Right.End].Epsilon.push_back(Joined.End);
+					Left = Joined;
+				}
+				return Left;
+			}
+
+			Fragment ParseSequence()
+			{
+				Fragment Result = MakeEmpty();
+				while (Error.empty() && !AtEnd() && Pattern[Pos] != '|' && Pattern[Pos] != ')')
+				{
+					const Fragment Next = ParseRepeat();
+					States[Result.End].Epsilon.push_back(Next.Start);
+					Result.End = Next.End;
+				}
+				return Result;
+			}
+
+			Fragment ParseRepeat()
+			{
+				Fragment Atom = ParseAtom();
+				while (Error.empty() && !AtEnd() && (Pattern[Pos] == '*' || Pattern[Pos] == '+' || Pattern[Pos] == '?'))
+				{
+					const char Op = Pattern[Pos++];
+					const Fragment Repeat{ NewState(), NewState() };
+					States[Repeat.Start].Epsilon.push_back(Atom.Start);
+					States[Atom.End].Epsilon.push_back(Repeat.End);
+					if (Op != '+')
+					{
+						States[Repeat.Start].Epsilon.push_back(Repeat.End);
+					}
+					if (Op != '?')
+					{
+						States[Atom.End].Epsilon.push_back(Atom.Start);
+					}
+					Atom = Repeat;
+				}
+				return Atom;
+			}
+
+			Fragment ParseAtom()
+			{
+				const char c = Pattern[Pos++];
+				CharSet Chars;
+				switch (c)
+				{
+				case '(':
+				{
+					const Fragment Inner = ParseAlternation();
+					if (Error.empty() && (AtEnd() || Pattern[Pos] != ')'))
+					{
+						Error = "missing ')'";
+					}
+					Pos++;
+					return Inner;
+				}
+				case '[':
+					ParseClass(Chars);
+					break;
+				case '.':
+					Chars.set();
+					Chars.reset('\n');
+					break;
+				case '\\':
+				{
+					char Escaped;
+					ParseEscape(Chars, Escaped);
+					break;
+				}
+				case '*':
+				case '+':
+				case '?':
+					Error = "nothing to repeat";
+					break;
+				default:
+					Chars.set(static_cast<uint8>(c));
+					break;
+				}
+				return MakeChars(Chars);
+			}
+
+			static int32 HexValue(char c)
+			{
+				if (c >= '0' && c <= '9') return c - '0';
+				if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+				if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+				return -1;
+			}
+
+			static void AddRange(CharSet& Chars, char First, char Last)
+			{
+				for (int32 c = static_cast<uint8>(First); c <= static_cast<uint8>(Last); c++)
+				{
+					Chars.set(c);
+				}
+			}
+
+			// after a backslash, false when the escape is a class like \d rather than a single char
+			bool ParseEscape(CharSet& Chars, char& OutChar)
+			{
+				if (AtEnd())
+				{
+					Error = "trailing '\\'";
+					return false;
+				}
+				char c = Pattern[Pos++];
+				CharSet Class;
+				switch (c)
+				{
+				case 'd':
+				case 'D':
+					AddRange(Class, '0', '9');
+					break;
+				case 'w':
+				case 'W':
+					AddRange(Class, 'a', 'z');
+					AddRange(Class, 'A', 'Z');
+					AddRange(Class, '0', '9');
+					Class.set('_');
+					break;
+				case 's':
+				case 'S':
+					for (const char Blank : { ' ', '\t', '\r', '\n', '\f', '\v' })
+					{
+						Class.set(static_cast<uint8>(Blank));
+					}
+					break;
+				case 'n': c = '\n'; break;
+				case 't': c = '\t'; break;
+				case 'r': c = '\r'; break;
+				case '0': c = '\0'; break;
+				case 'x':
+				{
+					const int32 High = Pos < Pattern.size() ? HexValue(Pattern[Pos]) : -1;
+					const int32 Low = Pos + 1 < Pattern.size() ? HexValue(Pattern[Pos + 1]) : -1;
+					if (High < 0 || Low < 0)
+					{
+						Error = "\\x needs two hex digits";
+						return false;
+					}
+					Pos += 2;
+					c = static_cast<char>(High * 16 + Low);
+					break;
+				}
+				default:
+					break;
+				}
+				if (Class.any())
+				{
+					Chars |= (c >= 'A' && c <= 'Z') ? ~Class : Class;
+					return false;
+				}
+				Chars.set(static_cast<uint8>(c));
+				OutChar = c;
+				return true;
+			}
+
+			// after '[', up to and including the closing ']'
+			void ParseClass(CharSet& Chars)
+			{
+				const bool bNegate = !AtEnd() && Pattern[Pos] == '^';
+				if (bNegate)
+				{
+					Pos++;
+				}
+				bool bFirst = true;
+				while (Error.empty())
+				{
+					if (AtEnd())
+					{
+						Error = "missing ']'";
+						return;
+					}
+					char c = Pattern[Pos++];
+					if (c == ']' && !bFirst)
+					{
+						break;
+					}
+					bFirst = false;
+					if (c == '\\' && !ParseEscape(Chars, c))
+					{
+						continue;
+					}
+					if (Pos + 1 < Pattern.size() && Pattern[Pos] == '-' && Pattern[Pos + 1] != ']')
+					{
+						Pos++;
+						char Last = Pattern[Pos++];
+						CharSet Ignored;
+						if (Last == '\\' && !ParseEscape(Ignored, Last))
+						{
+							Error = "invalid range";
+							return;
+						}
+						if (static_cast<uint8>(Last) < static_cast<uint8>(c))
+						{
+							Error = "invalid range";
+							return;
+						}
+						AddRange(Chars, c, Last);
+					}
+					else
+					{
+						Chars.set(static_cast<uint8>(c));
+					}
+				}
+				if (bNegate)
+				{
+					Chars.flip();
+				}
+			}
+
+			Re::Vector<NFAState>& States;
+			const Re::String& Pattern;
+			size_t Pos = 0;
+			Re::String Error;
+		};
+
+		void Closure(const Re::Vector<NFAState>& States, Re::Vector<int32>& InOutSet, Re::Vector<uint8>& Seen)
+		{
+			std::fill(Seen.begin(), Seen.end(), 0);
+			Re::Vector<int32> Pending = InOutSet;
+			InOutSet.clear();
+			while (!Pending.empty())
+			{
+				const int32 State = Pending.back();
+				Pending.pop_back();
+				if (Seen[State])
+				{
+					continue;
+				}
+				Seen[State] = 1;
+				InOutSet.push_back(State);
+				for (const int32 Next : States[State].Epsilon)
+				{
+					Pending.push_back(Next);
+				}
+			}
+			std::sort(InOutSet.begin(), InOutSet.end());
+		}
+	}
+
+	Re::SharedPtr<DFALexer> DFALexer::Build(const Re::Vector<TokenPattern>& Patterns, Re::String& OutError)
+	{
+		// 1. one NFA, a start state branching into every pattern
+		Re::Vector<NFAState> States;
+		States.emplace_back();
+		for (size_t i = 0; i < Patterns.size(); i++)
+		{
+			Fragment PatternFragment;
+			RegexCompiler Compiler(States, Patterns[i].Pattern);
+			if (!Compiler.Compile(PatternFragment, OutError))
+			{
+				OutError = "token " + Patterns[i].Name + ": " + OutError;
+				return nullptr;
+			}
+			States[0].Epsilon.push_back(PatternFragment.Start);
+			States[PatternFragment.End].Accept = static_cast<int32>(i);
+		}
+
+		auto Result = Re::MakeShared<DFALexer>();
+		Result->Patterns = Patterns;
+
+		// 2. bytes that every char set treats alike share an input class
+		Re::Vector<CharSet> Sets;
+		for (const NFAState& State : States)
+		{
+			if (State.Next >= 0 && std::find(Sets.begin(), Sets.end(), State.Chars) == Sets.end())
+			{
+				Sets.push_back(State.Chars);
+			}
+		}
+		Re::Map<Re::String, int32> Signatures;
+		Re::Vector<int32> ClassBytes;
+		for (int32 Byte = 0; Byte < 256; Byte++)
+		{
+			Re::String Signature(Sets.size(), '0');
+			for (size_t i = 0; i < Sets.size(); i++)
+			{
+				Signature[i] = Sets[i].test(Byte) ? '1' : '0';
+			}
+			auto It = Signatures.find(Signature);
+			if (It == Signatures.end())
+			{
+				It = Signatures.insert(RE_MAKE_PAIR(Signature, static_cast<int32>(ClassBytes.size()))).first;
+				ClassBytes.push_back(Byte);
+			}
+			Result->ByteClasses[Byte] = static_cast<uint8>(It->second);
+		}
+		const int32 ClassCount = static_cast<int32>(ClassBytes.size());
+
+		// 3. subset construction
+		Re::Vector<uint8> Seen(States.size());
+		Re::Vector<Re::Vector<int32>> DStates;
+		Re::Map<Re::Vector<int32>, int32> DStateIds;
+		Re::Vector<int32> Transitions;
+		Re::Vector<int32> Accepts;
+
+		Re::Vector<int32> Start{ 0 };
+		Closure(States, Start, Seen);
+		DStateIds[Start] = 0;
+		DStates.push_back(Start);
+		for (size_t Current = 0; Current < DStates.size(); Current++)
+		{
+			int32 Accept = -1;
+			for (const int32 State : DStates[Current])
+			{
+				if (States[State].Accept >= 0 && (Accept < 0 || States[State].Accept < Accept))
+				{
+					Accept = States[State].Accept;
+				}
+			}
+			Accepts.push_back(Accept);
+
+			for (int32 Class = 0; Class < ClassCount; Class++)
+			{
+				Re::Vector<int32> Moved;
+				for (const int32 State : DStates[Current])
+				{
+					if (States[State].Next >= 0 && States[State].Chars.test(ClassBytes[Class]))
+					{
+						Moved.push_back(States[State].Next);
+					}
+				}
+				int32 NextId = -1;
+				if (!Moved.empty())
+				{
+					Closure(States, Moved, Seen);
+					auto It = DStateIds.find(Moved);
+					if (It == DStateIds.end())
+					{
+						It = DStateIds.insert(RE_MAKE_PAIR(Moved, static_cast<int32>(DStates.size()))).first;
+						DStates.push_back(Moved);
+					}
+					NextId = It->second;
+				}
+				Transitions.push_back(NextId);
+			}
+		}
+		const int32 StateCount = static_cast<int32>(DStates.size());
+
+		// 4. states that can no longer reach an accept end the match right away
+		Re::Vector<uint8> Productive(StateCount, 0);
+		for (bool bChanged = true; bChanged;)
+		{
+			bChanged = false;
+			for (int32 State = 0; State < StateCount; State++)
+			{
+				if (Productive[State])
+				{
+					continue;
+				}
+				bool bProductive = Accepts[State] >= 0;
+				for (int32 Class = 0; Class < ClassCount && !bProductive; Class++)
+				{
+					const int32 Next = Transitions[State * ClassCount + Class];
+					bProductive = Next >= 0 && Productive[Next];
+				}
+				if (bProductive)
+				{
+					Productive[State] = 1;
+					bChanged = true;
+				}
+			}
+		}
+		for (int32& Next : Transitions)
+		{
+			if (Next >= 0 && !Productive[Next])
+			{
+				Next = -1;
+			}
+		}
+
+		// 5. Moore minimization, split partitions until no state disagrees with its partition
+		Re::Vector<int32> Partition(StateCount);
+		int32 PartitionCount = 0;
+		for (;;)
+		{
+			Re::Map<Re::Vector<int32>, int32> Keys;
+			Re::Vector<int32> Refined(StateCount);
+			for (int32 State = 0; State < StateCount; State++)
+			{
+				Re::Vector<int32> Key;
+				Key.reserve(ClassCount + 1);
+				Key.push_back(PartitionCount == 0 ? Accepts[State] : Partition[State]);
+				if (PartitionCount != 0)
+				{
+					for (int32 Class = 0; Class < ClassCount; Class++)
+					{
+						const int32 Next = Transitions[State * ClassCount + Class];
+						Key.push_back(Next < 0 ? -1 : Partition[Next]);
+					}
+				}
+				// ids follow the first state of each partition, the start state keeps 0
+				auto It = Keys.insert(RE_MAKE_PAIR(Key, static_cast<int32>(Keys.size()))).first;
+				Refined[State] = It->second;
+			}
+			const bool bStable = static_cast<int32>(Keys.size()) == PartitionCount;
+			Partition = Refined;
+			PartitionCount = static_cast<int32>(Keys.size());
+			if (bStable)
+			{
+				break;
+			}
+		}
+
+		Result->ClassCount = ClassCount;
+		Result->Transitions.assign(static_cast<size_t>(PartitionCount) * ClassCount, -1);
+		Result->Accepts.assign(PartitionCount, -1);
+		for (int32 State = 0; State < StateCount; State++)
+		{
+			const int32 Target = Partition[State];
+			Result->Accepts[Target] = Accepts[State];
+			for (int32 Class = 0; Class < ClassCount; Class++)
+			{
+				const int32 Next = Transitions[State * ClassCount + Class];
+				Result->Transitions[Target * ClassCount + Class] = Next < 0 ? -1 : Partition[Next];
+			}
+		}
+		return Result;
+	}
+
+	void DFALexer::ClassifyToken(Token& InOutToken, int32 PatternIndex) const
+	{
+		const std::string_view Text = InOutToken.GetTokenView();
+		switch (Patterns[PatternIndex].Kind)
+		{
+		case ETokenPatternKind::Number:
+		{
+			int64 Length = 0;
+			if (ScanNumber(Text.data(), Text.data() + Text.size(), InOutToken, Length) == ENumberScanResult::NotANumber)
+			{
+				InOutToken.SetConstInt64(0);
+			}
+			break;
+		}
+		case ETokenPatternKind::String:
+			InOutToken.SetConstString(Text.size() >= 2 ? static_cast<int32>(Text.size()) - 2 : 0);
+			break;
+		case ETokenPatternKind::Symbol:
+			InOutToken.TokenType = ETokenType::Symbol;
+			break;
+		default:
+			InOutToken.TokenType = ETokenType::Identifier;
+			break;
+		}
+		InOutToken.TerminalId = static_cast<uint16>(PatternIndex + 1);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	class Token;
+
+	enum class ETokenPatternKind : uint8
+	{
+		// matched and dropped, whitespace and comments
+		Skip,
+		Identifier,
+		Symbol,
+		// integer or floating point constant
+		Number,
+		// string constant, the first and the last char of the match are the delimiters
+		String,
+	};
+
+	struct TokenPattern
+	{
+		Re::String Name;
+		// regex: literals, '.', [a-z] / [^...] classes, \d \w \s \n \t \xNN escapes, ( ) | * + ?
+		Re::String Pattern;
+		ETokenPatternKind Kind = ETokenPatternKind::Identifier;
+	};
+
+	/**
+	 * Table-driven lexer compiled from token patterns into a single minimized DFA.
+	 * The longest match wins, between matches of the same length the pattern declared first wins.
+	 * Tokens lexed by it carry the pattern index + 1 as their terminal id.
+	 */
+	class RECODEPARSER_API DFALexer
+	{
+	public:
+		/**
+		 * Compiles the patterns.
+		 *
+		 * @return the lexer, or nullptr with OutError filled when a pattern is malformed.
+		 */
+		static Re::SharedPtr<DFALexer> Build(const Re::Vector<TokenPattern>& Patterns, Re::String& OutError);
+
+		/**
+		 * Runs the DFA at Pos.
+		 *
+		 * @return length of the longest match, 0 when no pattern matches.
+		 */
+		int32 Match(const char* Text, int64 Pos, int64 Len, int32& OutPattern) const
+		{
+			int32 State = 0;
+			int32 MatchLength = 0;
+			for (int64 i = Pos; i < Len; i++)
+			{
+				State = Transitions[State * ClassCount + ByteClasses[static_cast<uint8>(Text[i])]];
+				if (State < 0)
+				{
+					break;
+				}
+				if (Accepts[State] >= 0)
+				{
+					OutPattern = Accepts[State];
+					MatchLength = static_cast<int32>(i - Pos + 1);
+				}
+			}
+			return MatchLength;
+		}
+
+		/** Sets the type and value of a token spanning a match of the pattern. */
+		void ClassifyToken(Token& InOutToken, int32 PatternIndex) const;
+
+		const TokenPattern& GetPattern(int32 Index) const { return Patterns[Index]; }
+		int32 GetPatternCount() const { return static_cast<int32>(Patterns.size()); }
+		int32 GetStateCount() const { return static_cast<int32>(Accepts.size()); }
+
+	private:
+		Re::Vector<TokenPattern> Patterns;
+		// byte -> input class, bytes no pattern tells apart share a class
+		uint8 ByteClasses[256] = {};
+		int32 ClassCount = 0;
+		// State * ClassCount + Class -> next state, -1 when the match cannot continue
+		Re::Vector<int32> Transitions;
+		// pattern accepted in a state, -1 for none
+		Re::Vector<int32> Accepts;
+	};
+}
@@ -0,0 +1,160 @@
+#include "Diagnostics.h"
+#include <algorithm>
+
+namespace ReParser
+{
+	namespace
+	{
+		struct DiagnosticInfo
+		{
+			const char* Name;
+			EDiagnosticSeverity Severity;
+			const char* Message;
+		};
+
+		constexpr DiagnosticInfo Infos[] = {
+#define RE_DIAGNOSTIC_INFO(Name, Severity, Message) { #Name, EDiagnosticSeverity::Severity, Message },
+			RE_PARSER_DIAGNOSTICS(RE_DIAGNOSTIC_INFO)
+#undef RE_DIAGNOSTIC_INFO
+		};
+		static_assert(sizeof(Infos) / sizeof(Infos[0]) == static_cast<size_t>(EDiagnosticCode::Count));
+	}
+
+	void DiagnosticEngine::Report(EDiagnosticCode Code, int64 Offset, std::initializer_list<DiagnosticValue> InArgs)
+	{
+		const EDiagnosticSeverity Severity = GetSeverity(Code);
+		if (Severity == EDiagnosticSeverity::Warning)
+		{
+			WarningCount++;
+		}
+		else
+		{
+			ErrorCount++;
+			bFatal |= Severity == EDiagnosticSeverity::Fatal;
+		}
+		if (ErrorLimit > 0 && Diagnostics.size() >= static_cast<size_t>(ErrorLimit))
+		{
+			return;
+		}
+
+		Diagnostic& Result = Diagnostics.emplace_back();
+		Result.Code = Code;
+		Result.Severity = Severity;
+		Result.FileIndex = static_cast<int32>(FileNames.size()) - 1;
+		Result.Offset = Offset;
+		for (const DiagnosticValue& Value : InArgs)
+		{
+			if (Result.ArgCount == Diagnostic::MaxArgs)
+			{
+				break;
+			}
+			Diagnostic::Arg& Out = Result.Args[Result.ArgCount++];
+			Out.Int = Value.Int;
+			if (Value.bText || Value.bChar)
+			{
+				Out.bText = true;
+				Out.Int = static_cast<int64>(ArgText.size());
+				if (Value.bChar)
+				{
+					ArgText += static_cast<char>(Value.Int);
+				}
+				else
+				{
+					ArgText += Value.Text;
+				}
+				Out.TextLength = static_cast<uint32>(static_cast<int64>(ArgText.size()) - Out.Int);
+			}
+		}
+	}
+
+	void DiagnosticEngine::Clear()
+	{
+		Diagnostics.clear();
+		ArgText.clear();
+		FileNames.clear();
+		LocatedNum = 0;
+		ErrorCount = 0;
+		WarningCount = 0;
+		bFatal = false;
+	}
+
+	void DiagnosticEngine::SetFileName(const Re::String& InFileName)
+	{
+		if (FileNames.empty() || FileNames.back() != InFileName)
+		{
+			FileNames.push_back(InFileName);
+		}
+	}
+
+	void DiagnosticEngine::Locate(LineIndex& Lines)
+	{
+		for (; LocatedNum < Diagnostics.size(); LocatedNum++)
+		{
+			Diagnostic& Entry = Diagnostics[LocatedNum];
+			if (Entry.Offset >= 0)
+			{
+				Entry.Location = Lines.GetLocation(Entry.Offset);
+				Entry.bLocated = true;
+			}
+		}
+	}
+
+	Re::String DiagnosticEngine::Format(const Diagnostic& InDiagnostic) const
+	{
+		Re::String Result;
+		for (const char* Message = GetMessage(InDiagnostic.Code); *Message; Message++)
+		{
+			const int32 Index = Message[0] == '{' && Message[1] >= '0' && Message[1] <= '9' && Message[2] == '}' ? Message[1] - '0' : -1;
+			if (Index < 0)
+			{
+				Result += *Message;
+				continue;
+			}
+			if (Index < InDiagnostic.ArgCount)
+			{
+				const Diagnostic::Arg& Value = InDiagnostic.Args[Index];
+				Result += Value.bText ? ArgText.substr(static_cast<size_t>(Value.Int), Value.TextLength) : std::to_string(Value.Int);
+			}
+			Message += 2;
+		}
+
+		if (InDiagnostic.FileIndex >= 0 || InDiagnostic.bLocated)
+		{
+			Result += " : at ";
+			if (InDiagnostic.FileIndex >= 0)
+			{
+				Result += FileNames[static_cast<size_t>(InDiagnostic.FileIndex)];
+			}
+			if (InDiagnostic.bLocated)
+			{
+				Result += " : " + std::to_string(InDiagnostic.Location.Line) + ":" + std::to_string(InDiagnostic.Location.Column);
+			}
+		}
+		return Result;
+	}
+
+	EDiagnosticSeverity DiagnosticEngine::GetSeverity(EDiagnosticCode Code)
+	{
+		return Infos[static_cast<size_t>(Code)].Severity;
+	}
+
+	const char* DiagnosticEngine::GetMessage(EDiagnosticCode Code)
+	{
+		return Infos[static_cast<size_t>(Code)].Message;
+	}
+
+	const char* DiagnosticEngine::GetCodeName(EDiagnosticCode Code)
+	{
+		return Infos[static_cast<size_t>(Code)].Name;
+	}
+
+	void DiagnosticEngine::Rewind(const Mark& InMark)
+	{
+		Diagnostics.resize(InMark.Num);
+		ArgText.resize(InMark.TextSize);
+		LocatedNum = std::min(LocatedNum, InMark.Num);
+		ErrorCount = InMark.ErrorCount;
+		WarningCount = InMark.WarningCount;
+		bFatal = InMark.bFatal;
+	}
+}
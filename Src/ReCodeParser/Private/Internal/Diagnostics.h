@@ -0,0 +1,205 @@
+#pragma once
+#include <initializer_list>
+#include <string_view>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+#include "LineIndex.h"
+
+// Name, severity and message of every diagnostic, {0} and {1} stand for the arguments
+#define RE_PARSER_DIAGNOSTICS(X) \
+	X(Custom, Error, "{0}") \
+	X(UnexpectedCommentEnd, Error, "Unexpected '*/' outside of comment") \
+	X(UnterminatedComment, Error, "End of input encountered inside comment") \
+	X(InvalidEscape, Error, "Invalid escape sequence: {0}") \
+	X(NumberOutOfRange, Error, "Number constant out of range: {0}") \
+	X(UnterminatedChar, Error, "Unterminated character constant") \
+	X(UnterminatedString, Error, "Unterminated string constant: {0}") \
+	X(InvalidUtf8, Error, "Invalid UTF-8 sequence") \
+	X(UnrecognizedChar, Error, "Unrecognized character '{0}'") \
+	X(TokenTooLong, Error, "Token of {0} bytes is too long, cut to {1}") \
+	X(StreamReadError, Fatal, "Read error in stream") \
+	X(EditNotPreTokenized, Error, "Edit of a source that is not pre-tokenized") \
+	X(EditOutOfRange, Error, "Edit out of the source range : {0} + {1}") \
+	X(ExitEarly, Error, "Exit Early !! {0}") \
+	X(MissingConstInt, Error, "Missing constant integer : {0}") \
+	X(MissingSemiBefore, Error, "Missing ';' before {0}") \
+	X(MissingSemi, Error, "Missing ';'") \
+	X(MissingSymbol, Error, "Missing {0} in {1}") \
+	X(MissingInt, Error, "Missing integer '{0}' in {1}") \
+	X(MissingAnyInt, Error, "Missing integer in {0}") \
+	X(UnexpectedEndOfFile, Error, "unexpected end of file") \
+	X(UnexpectedEndOfLine, Error, "unexpect EOL") \
+	X(InternalError, Fatal, "unknown error !! please review parser code..") \
+	X(IniNullFile, Fatal, "code file is null !!") \
+	X(IniNotIniFile, Fatal, "current code file is not a ini file !! {0}") \
+	X(IniUnexpectedScope, Error, "unexcepted scope !!!") \
+	X(IniNullScope, Fatal, "scope or file is null !!!") \
+	X(IniEmptyItemName, Error, "ini section item name is empty") \
+	X(IniDuplicateSection, Error, "ini section {0} has added !!") \
+	X(IniConstItemName, Error, "section item name cannot be const value !!") \
+	X(IniDuplicateItem, Error, "section item {0} has been added") \
+	X(IniItemFailed, Error, "parse ini section item failed !!") \
+	X(IniExpectedIdentifier, Error, "must start with a identify !!") \
+	X(IniInvalidToken, Error, "invalid token type !!") \
+	X(IniUnexpectedToken, Error, "unexpected token type") \
+	X(IniInvalidMapItemName, Error, "invalid map item name {0}") \
+	X(IniDuplicateMapKey, Error, "repeat key in map item !!") \
+	X(BNFUnknownState, Fatal, "Unknown BNF State, failed to parse !!") \
+	X(BNFExpectedRuleStart, Error, "BNF line should start with '<'") \
+	X(BNFUnknownDirective, Error, "unknown BNF directive") \
+	X(BNFInvalidTokenDeclaration, Error, "BNF token must be declared as %token <kind> <Name> \"<regex>\"") \
+	X(BNFUnknownTokenKind, Error, "unknown BNF token kind {0}") \
+	X(BNFDuplicateToken, Error, "BNF token name {0} repeated !!") \
+	X(BNFInvalidKeyword, Error, "BNF keyword must be an identifier") \
+	X(BNFInvalidOperator, Error, "BNF operator must be a string of 2 chars or more") \
+	X(BNFInvalidPrecedence, Error, "BNF %{0} operators must be strings") \
+	X(BNFEmptyRuleName, Error, "BNF rule name cannot be null") \
+	X(BNFRuleIsToken, Error, "BNF rule name {0} is declared as a token !!") \
+	X(BNFDuplicateRule, Error, "BNF rule name {0} repeated !!") \
+	X(BNFExpectedDefine, Error, "BNF rule must split by '::=' operator") \
+	X(BNFGroupNotEmpty, Fatal, "group node must be empty before parse !!") \
+	X(BNFRuleFailed, Error, "parse BNF rule failed") \
+	X(BNFNodeFailed, Error, "parse ASTParser failed !!") \
+	X(BNFGroupFailed, Error, "parse group node failed !!") \
+	X(BNFInvalidRule, Error, "invalid rule info") \
+	X(ASTUnknownCustomParser, Error, "cannot find custom parser {0}") \
+	X(ASTLeftRecursionNotPreTokenized, Error, "Left-recursive rule {0} needs a pre-tokenized input") \
+	X(ASTNonAssocChain, Error, "Non-associative operator {0} cannot follow {1}")
+
+namespace ReParser
+{
+	enum class EDiagnosticSeverity : uint8
+	{
+		Warning,
+		Error,
+		// stops the parsing whatever the abort policy
+		Fatal,
+	};
+
+	enum class EDiagnosticCode : uint16
+	{
+#define RE_DIAGNOSTIC_CODE(Name, Severity, Message) Name,
+		RE_PARSER_DIAGNOSTICS(RE_DIAGNOSTIC_CODE)
+#undef RE_DIAGNOSTIC_CODE
+		Count
+	};
+
+	/** When the parsing stops because of the errors reported. */
+	enum class EDiagnosticAbortPolicy : uint8
+	{
+		// only fatal diagnostics stop it
+		Never,
+		FirstError,
+		// once the error limit is reached
+		ErrorLimit,
+	};
+
+	/** Argument of a diagnostic, an integer, a char or a short text copied when it is reported. */
+	struct DiagnosticValue
+	{
+		DiagnosticValue(int64 InInt) : Int(InInt) {}
+		DiagnosticValue(int32 InInt) : Int(InInt) {}
+		DiagnosticValue(char InChar) : Int(static_cast<uint8>(InChar)), bChar(true) {}
+		DiagnosticValue(std::string_view InText) : Text(InText), bText(true) {}
+		DiagnosticValue(const char* InText) : Text(InText ? InText : ""), bText(true) {}
+		DiagnosticValue(const Re::String& InText) : Text(InText), bText(true) {}
+
+		int64 Int = 0;
+		std::string_view Text;
+		bool bChar = false;
+		bool bText = false;
+	};
+
+	/** A reported diagnostic, its message is only formatted when asked for. */
+	struct Diagnostic
+	{
+		static constexpr int32 MaxArgs = 2;
+
+		struct Arg
+		{
+			// the integer, or the offset of the text in the argument storage
+			int64 Int = 0;
+			uint32 TextLength = 0;
+			bool bText = false;
+		};
+
+		EDiagnosticCode Code = EDiagnosticCode::Custom;
+		EDiagnosticSeverity Severity = EDiagnosticSeverity::Error;
+		uint8 ArgCount = 0;
+		int32 FileIndex = -1;
+		// source offset, negative when the diagnostic has no position
+		int64 Offset = -1;
+		// filled from the offset when the source changes or the message is formatted
+		SourceLocation Location;
+		bool bLocated = false;
+		Arg Args[MaxArgs];
+	};
+
+	/**
+	 * Diagnostics of a parser stored as codes, offsets and a few arguments, so reporting costs no
+	 * formatting. Past the error limit diagnostics are only counted, the abort policy tells the
+	 * parser when to stop.
+	 */
+	class RECODEPARSER_API DiagnosticEngine
+	{
+	public:
+		/** Stored diagnostics, counts and argument text, to roll back a report. */
+		struct Mark
+		{
+			size_t Num = 0;
+			size_t TextSize = 0;
+			int32 ErrorCount = 0;
+			int32 WarningCount = 0;
+			bool bFatal = false;
+		};
+
+		void Report(EDiagnosticCode Code, int64 Offset, std::initializer_list<DiagnosticValue> InArgs = {});
+
+		/** Forgets every diagnostic and count, the limit and policy stay. */
+		void Clear();
+
+		/** File the diagnostics reported afterwards belong to. */
+		void SetFileName(const Re::String& InFileName);
+
+		/** Resolves the locations of the diagnostics not located yet while Lines still indexes their source. */
+		void Locate(LineIndex& Lines);
+
+		/** Diagnostics past the limit are counted but not stored, 0 stores them all. */
+		void SetErrorLimit(int32 InLimit) { ErrorLimit = InLimit; }
+		void SetAbortPolicy(EDiagnosticAbortPolicy InPolicy) { AbortPolicy = InPolicy; }
+
+		bool ShouldAbort() const
+		{
+			return bFatal || (AbortPolicy == EDiagnosticAbortPolicy::FirstError && ErrorCount > 0)
+				|| (AbortPolicy == EDiagnosticAbortPolicy::ErrorLimit && ErrorLimit > 0 && ErrorCount >= ErrorLimit);
+		}
+
+		bool HasErrors() const { return ErrorCount > 0; }
+		int32 GetErrorCount() const { return ErrorCount; }
+		int32 GetWarningCount() const { return WarningCount; }
+		const Re::Vector<Diagnostic>& GetDiagnostics() const { return Diagnostics; }
+
+		/** "message : at file : line:column", Locate must have run since it was reported. */
+		Re::String Format(const Diagnostic& InDiagnostic) const;
+
+		static EDiagnosticSeverity GetSeverity(EDiagnosticCode Code);
+		static const char* GetMessage(EDiagnosticCode Code);
+		static const char* GetCodeName(EDiagnosticCode Code);
+
+		Mark GetMark() const { return { Diagnostics.size(), ArgText.size(), ErrorCount, WarningCount, bFatal }; }
+		void Rewind(const Mark& InMark);
+
+	private:
+		Re::Vector<Diagnostic> Diagnostics;
+		// text of the arguments of all diagnostics, one after another
+		Re::String ArgText;
+		Re::Vector<Re::String> FileNames;
+		// diagnostics before it are located
+		size_t LocatedNum = 0;
+		int32 ErrorCount = 0;
+		int32 WarningCount = 0;
+		bool bFatal = false;
+		int32 ErrorLimit = 0;
+		EDiagnosticAbortPolicy AbortPolicy = EDiagnosticAbortPolicy::Never;
+	};
+}
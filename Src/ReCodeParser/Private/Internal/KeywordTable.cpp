@@ -0,0 +1,44 @@
+#include "KeywordTable.h"
+
+#include <algorithm>
+
+namespace ReParser
+{
+	KeywordTable::KeywordTable(const Re::Vector<Re::String>& InWords)
+	{
+		for (const Re::String& Word : InWords)
+		{
+			if (std::find(Words.begin(), Words.end(), Word) == Words.end())
+			{
+				Words.push_back(Word);
+			}
+		}
+
+		// search a seed that puts every word in its own slot, grow the table when seeds run out
+		uint32 Size = 2;
+		while (Size < Words.size() * 2)
+		{
+			Size *= 2;
+		}
+		for (;; Size *= 2)
+		{
+			Mask = Size - 1;
+			for (Seed = 0; Seed < 4096; Seed++)
+			{
+				Slots.assign(Size, Slot{});
+				bool bCollision = false;
+				for (size_t i = 0; i < Words.size() && !bCollision; i++)
+				{
+					Slot& Entry = Slots[Hash(Words[i], Seed) & Mask];
+					bCollision = Entry.Id != 0;
+					Entry.Id = static_cast<int32>(i) + 1;
+					Entry.Length = static_cast<uint32>(Words[i].size());
+				}
+				if (!bCollision)
+				{
+					return;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string_view>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * Reserved words of a parser compiled into a collision-free hash table, so classifying an
+	 * identifier costs one hash and at most one compare. Keyword ids follow the declaration
+	 * order starting at 1, 0 means the word is not a keyword.
+	 */
+	class RECODEPARSER_API KeywordTable
+	{
+	public:
+		explicit KeywordTable(const Re::Vector<Re::String>& InWords);
+
+		int32 Find(std::string_view Word) const
+		{
+			const Slot& Entry = Slots[Hash(Word, Seed) & Mask];
+			if (Entry.Id == 0 || Word.size() != Entry.Length)
+			{
+				return 0;
+			}
+			return std::memcmp(Words[Entry.Id - 1].data(), Word.data(), Word.size()) == 0 ? Entry.Id : 0;
+		}
+
+		const Re::String& GetKeyword(int32 Id) const { return Words[Id - 1]; }
+		int32 Num() const { return static_cast<int32>(Words.size()); }
+
+	private:
+		struct Slot
+		{
+			int32 Id = 0;
+			uint32 Length = 0;
+		};
+
+		static uint32 Hash(std::string_view Word, uint32 InSeed)
+		{
+			uint32 Result = 2166136261u ^ InSeed;
+			for (const char c : Word)
+			{
+				Result = (Result ^ static_cast<uint8>(c)) * 16777619u;
+			}
+			return Result ^ (Result >> 15);
+		}
+
+		Re::Vector<Re::String> Words;
+		Re::Vector<Slot> Slots;
+		uint32 Mask = 0;
+		uint32 Seed = 0;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "CharClass.h"
+#include "Token.h"
+
+namespace ReParser
+{
+	/**
+	 * Compile-time lexing rules for TBaseParser, the C-like syntax BaseParser lexes by default.
+	 * A policy derives from this one and hides the members it changes, e.g.
+	 *
+	 *   struct MyLexPolicy : DefaultLexPolicy
+	 *   {
+	 *       static constexpr bool IsLineComment(char c, char Next) { return c == '#'; }
+	 *   };
+	 */
+	struct DefaultLexPolicy
+	{
+		// Character classification, the identifier charset among others
+		static constexpr CharClassTable Classes = CharClassTable::MakeDefault();
+
+		// Whether Classes keeps the default whitespace, EOL and identifier chars the SIMD scan kernels expect
+		static constexpr bool bScanKernels = true;
+
+		// Whether a backslash escapes the next char of string and char constants
+		static constexpr bool bBackslashEscapes = true;
+
+		static constexpr bool IsBeginComment(char c, char Next) { return c == '/' && Next == '*'; }
+		static constexpr bool IsEndComment(char c, char Next) { return c == '*' && Next == '/'; }
+		static constexpr bool IsLineComment(char c, char Next) { return c == '/' && Next == '/'; }
+
+		/** Turns an identifier token into a constant if it spells one of the keyword constants. */
+		static void LexKeyword(Token& InToken)
+		{
+			// the length picks the only candidate
+			const std::string_view Word = InToken.GetTokenView();
+			switch (Word.size())
+			{
+			case 4:
+				if (Word == "true")
+				{
+					InToken.SetConstBool(true);
+				}
+				break;
+			case 5:
+				if (Word == "false")
+				{
+					InToken.SetConstBool(false);
+				}
+				break;
+			case 7:
+				if (Word == "nullptr")
+				{
+					InToken.SetNullptr();
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	};
+}
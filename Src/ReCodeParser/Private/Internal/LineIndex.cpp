@@ -0,0 +1,64 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+
+#include "ScanKernels.h"
+
+namespace ReParser
+{
+	// scanned ahead of the offset asked for, so parsing front to back indexes the source in a few passes
+	static constexpr int64 IndexChunkSize = 64 * 1024;
+
+	void LineIndex::Reset(const char* InSource, int64 InLength)
+	{
+		Source = InSource;
+		Length = InLength;
+		IndexedEnd = 0;
+		LineStarts.assign(1, 0);
+	}
+
+	void LineIndex::Extend(const char* InSource, int64 InLength)
+	{
+		Source = InSource;
+		Length = InLength;
+	}
+
+	void LineIndex::Truncate(const char* InSource, int64 InLength, int64 Offset)
+	{
+		Source = InSource;
+		Length = InLength;
+		IndexedEnd = std::min(IndexedEnd, Offset);
+		// a line starting at Offset begins after a '\n' that is still there
+		LineStarts.erase(std::upper_bound(LineStarts.begin(), LineStarts.end(), IndexedEnd), LineStarts.end());
+	}
+
+	int64 LineIndex::GetLine(int64 Offset)
+	{
+		Offset = std::clamp<int64>(Offset, 0, Length);
+		if (Offset > IndexedEnd)
+		{
+			IndexUpTo(Offset);
+		}
+		// parsers mostly ask for the line they are on
+		if (Offset >= LineStarts.back())
+		{
+			return static_cast<int64>(LineStarts.size());
+		}
+		return static_cast<int64>(std::upper_bound(LineStarts.begin(), LineStarts.end(), Offset) - LineStarts.begin());
+	}
+
+	SourceLocation LineIndex::GetLocation(int64 Offset)
+	{
+		SourceLocation Location;
+		Location.Line = GetLine(Offset);
+		Location.Column = std::clamp<int64>(Offset, 0, Length) - LineStarts[Location.Line - 1] + 1;
+		return Location;
+	}
+
+	void LineIndex::IndexUpTo(int64 Offset)
+	{
+		const int64 End = std::min(Length, std::max(Offset, IndexedEnd + IndexChunkSize));
+		Scan::AppendLineStarts(Source, Source + IndexedEnd, Source + End, LineStarts);
+		IndexedEnd = End;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/** Line and column of a source offset, both start at 1. */
+	struct SourceLocation
+	{
+		int64 Line = 1;
+		int64 Column = 1;
+	};
+
+	/**
+	 * Start offsets of the lines of a source, so the lexer only tracks positions.
+	 * The table is built lazily, only as far into the source as the offsets asked for,
+	 * and offsets are mapped to lines by binary search.
+	 */
+	class RECODEPARSER_API LineIndex
+	{
+	public:
+		/** Starts indexing a new source, nothing is scanned until a line is asked for. */
+		void Reset(const char* InSource, int64 InLength);
+
+		/** More of the source was read or it moved, the lines indexed so far stay. */
+		void Extend(const char* InSource, int64 InLength);
+
+		/** The source changed from Offset on, forgets the lines starting after it. */
+		void Truncate(const char* InSource, int64 InLength, int64 Offset);
+
+		/** @return line of Offset, offsets past the end map to the last line. */
+		int64 GetLine(int64 Offset);
+
+		SourceLocation GetLocation(int64 Offset);
+
+	private:
+		/** Indexes the source at least up to Offset. */
+		void IndexUpTo(int64 Offset);
+
+		const char* Source = nullptr;
+		int64 Length = 0;
+		// every '\n' before IndexedEnd has its line in LineStarts
+		int64 IndexedEnd = 0;
+		Re::Vector<int64> LineStarts{ 0 };
+	};
+}
@@ -0,0 +1,177 @@
+#include "MappedSource.h"
+
+#include <cerrno>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ReParser
+{
+	MappedSource::~MappedSource()
+	{
+		Close();
+	}
+
+	bool MappedSource::Open(const Re::String& FilePath)
+	{
+		Close();
+		return Map(FilePath) || Read(FilePath);
+	}
+
+	void MappedSource::Assign(Re::String InContent)
+	{
+		Close();
+		Buffer = std::move(InContent);
+		Data = Buffer.data();
+		Size = Buffer.size();
+	}
+
+	void MappedSource::Close()
+	{
+		if (bMapped)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(Data);
+			CloseHandle(MappingHandle);
+			CloseHandle(FileHandle);
+			MappingHandle = nullptr;
+			FileHandle = nullptr;
+#else
+			munmap(const_cast<char*>(Data), Size);
+#endif
+		}
+		Data = "";
+		Size = 0;
+		bMapped = false;
+		Buffer.clear();
+	}
+
+#if defined(_WIN32)
+
+	bool MappedSource::Map(const Re::String& FilePath)
+	{
+		HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER FileSize;
+		// empty files cannot be mapped, they are read as an empty buffer
+		if (GetFileType(File) != FILE_TYPE_DISK || !GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+		{
+			CloseHandle(File);
+			return false;
+		}
+		HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* View = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!View)
+		{
+			if (Mapping)
+			{
+				CloseHandle(Mapping);
+			}
+			CloseHandle(File);
+			return false;
+		}
+		FileHandle = File;
+		MappingHandle = Mapping;
+		Data = static_cast<const char*>(View);
+		Size = static_cast<size_t>(FileSize.QuadPart);
+		bMapped = true;
+		return true;
+	}
+
+	bool MappedSource::Read(const Re::String& FilePath)
+	{
+		HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		char Chunk[64 * 1024];
+		DWORD ReadSize = 0;
+		bool bResult = true;
+		while ((bResult = ReadFile(File, Chunk, sizeof(Chunk), &ReadSize, nullptr) != FALSE) && ReadSize > 0)
+		{
+			Buffer.append(Chunk, ReadSize);
+		}
+		CloseHandle(File);
+		// a pipe reports its end as a broken pipe
+		bResult = bResult || GetLastError() == ERROR_BROKEN_PIPE;
+		Data = Buffer.data();
+		Size = Buffer.size();
+		return bResult;
+	}
+
+#else
+
+	bool MappedSource::Map(const Re::String& FilePath)
+	{
+		const int File = open(FilePath.c_str(), O_RDONLY);
+		if (File < 0)
+		{
+			return false;
+		}
+		struct stat Info;
+		// empty files cannot be mapped, they are read as an empty buffer
+		if (fstat(File, &Info) != 0 || !S_ISREG(Info.st_mode) || Info.st_size == 0)
+		{
+			close(File);
+			return false;
+		}
+		void* View = mmap(nullptr, static_cast<size_t>(Info.st_size), PROT_READ, MAP_PRIVATE, File, 0);
+		// the mapping keeps the file referenced
+		close(File);
+		if (View == MAP_FAILED)
+		{
+			return false;
+		}
+		// parsers read front to back, let the kernel read ahead and drop pages behind
+		madvise(View, static_cast<size_t>(Info.st_size), MADV_SEQUENTIAL);
+		Data = static_cast<const char*>(View);
+		Size = static_cast<size_t>(Info.st_size);
+		bMapped = true;
+		return true;
+	}
+
+	bool MappedSource::Read(const Re::String& FilePath)
+	{
+		const int File = open(FilePath.c_str(), O_RDONLY);
+		if (File < 0)
+		{
+			return false;
+		}
+		char Chunk[64 * 1024];
+		ssize_t ReadSize;
+		while ((ReadSize = read(File, Chunk, sizeof(Chunk))) != 0)
+		{
+			if (ReadSize < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			Buffer.append(Chunk, static_cast<size_t>(ReadSize));
+		}
+		close(File);
+		Data = Buffer.data();
+		Size = Buffer.size();
+		return ReadSize == 0;
+	}
+
+#endif
+}
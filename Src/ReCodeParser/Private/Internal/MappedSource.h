@@ -0,0 +1,47 @@
+#pragma once
+#include <string_view>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * Read-only content of a source file. Regular files are memory-mapped so parsers and
+	 * tokens point straight into the mapping, pipes and other unmappable files are read
+	 * into an owned buffer instead. The content carries no terminating NUL.
+	 */
+	class RECODEPARSER_API MappedSource
+	{
+	public:
+		MappedSource() = default;
+		~MappedSource();
+
+		MappedSource(const MappedSource&) = delete;
+		MappedSource& operator=(const MappedSource&) = delete;
+
+		/** @return false when the file cannot be opened or read, the content is empty then. */
+		bool Open(const Re::String& FilePath);
+
+		/** Takes the content from memory instead of a file. */
+		void Assign(Re::String InContent);
+
+		void Close();
+
+		std::string_view GetView() const { return std::string_view{ Data, Size }; }
+		bool IsMapped() const { return bMapped; }
+
+	private:
+		bool Map(const Re::String& FilePath);
+		bool Read(const Re::String& FilePath);
+
+		const char* Data = "";
+		size_t Size = 0;
+		bool bMapped = false;
+		// content of sources that are not mapped
+		Re::String Buffer;
+#if defined(_WIN32)
+		void* FileHandle = nullptr;
+		void* MappingHandle = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,126 @@
+#include "NumberScan.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include "Token.h"
+
+namespace ReParser
+{
+	static bool IsDecimalDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	static bool IsHexDigit(char c)
+	{
+		return IsDecimalDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+	}
+
+	ENumberScanResult ScanNumber(const char* Begin, const char* End, Token& OutToken, int64& OutLength)
+	{
+		OutLength = 0;
+		const char* Cursor = Begin;
+		bool bNegative = false;
+		if (Cursor < End && (*Cursor == '+' || *Cursor == '-'))
+		{
+			bNegative = *Cursor == '-';
+			Cursor++;
+		}
+		if (Cursor == End || !IsDecimalDigit(*Cursor))
+		{
+			return ENumberScanResult::NotANumber;
+		}
+
+		if (*Cursor == '0' && End - Cursor > 2 && (Cursor[1] == 'x' || Cursor[1] == 'X') && IsHexDigit(Cursor[2]))
+		{
+			uint64 Value = 0;
+			const std::from_chars_result Result = std::from_chars(Cursor + 2, End, Value, 16);
+			OutLength = Result.ptr - Begin;
+			ENumberScanResult ScanResult = ENumberScanResult::Ok;
+			if (Result.ec == std::errc::result_out_of_range)
+			{
+				// from_chars leaves the value alone, saturate to the widest bit pattern like decimals saturate to their limit
+				ScanResult = ENumberScanResult::OutOfRange;
+				Value = std::numeric_limits<uint64>::max();
+			}
+			// hex literals keep their bit pattern, 0xFFFFFFFFFFFFFFFF is -1
+			OutToken.SetConstInt64(static_cast<int64>(bNegative ? 0 - Value : Value));
+			return ScanResult;
+		}
+
+		// find the extent of the literal, from_chars parses exactly this range
+		const char* Digits = Cursor;
+		while (Cursor < End && IsDecimalDigit(*Cursor))
+		{
+			Cursor++;
+		}
+		bool bIsFloat = false;
+		if (Cursor < End && *Cursor == '.')
+		{
+			bIsFloat = true;
+			Cursor++;
+			while (Cursor < End && IsDecimalDigit(*Cursor))
+			{
+				Cursor++;
+			}
+		}
+		if (Cursor < End && (*Cursor == 'e' || *Cursor == 'E'))
+		{
+			const char* Exponent = Cursor + 1;
+			if (Exponent < End && (*Exponent == '+' || *Exponent == '-'))
+			{
+				Exponent++;
+			}
+			// a bare 'e' is not part of the number
+			if (Exponent < End && IsDecimalDigit(*Exponent))
+			{
+				bIsFloat = true;
+				Cursor = Exponent;
+				while (Cursor < End && IsDecimalDigit(*Cursor))
+				{
+					Cursor++;
+				}
+			}
+		}
+
+		ENumberScanResult ScanResult = ENumberScanResult::Ok;
+		if (bIsFloat)
+		{
+			double Value = 0;
+			const std::from_chars_result Result = std::from_chars(Digits, Cursor, Value);
+			if (Result.ec == std::errc::result_out_of_range)
+			{
+				// from_chars leaves the value alone, saturate to infinity or zero depending on the exponent sign
+				ScanResult = ENumberScanResult::OutOfRange;
+				const char* Exponent = std::find_if(Digits, Cursor, [](char c) { return c == 'e' || c == 'E'; });
+				Value = (Exponent + 1 < Cursor && Exponent[1] == '-') ? 0.0 : std::numeric_limits<double>::infinity();
+			}
+			Value = bNegative ? -Value : Value;
+			if (Cursor < End && (*Cursor == 'f' || *Cursor == 'F'))
+			{
+				Cursor++;
+				OutToken.SetConstFloat(static_cast<float>(Value));
+			}
+			else
+			{
+				OutToken.SetConstDouble(Value);
+			}
+		}
+		else
+		{
+			uint64 Value = 0;
+			const std::from_chars_result Result = std::from_chars(Digits, Cursor, Value);
+			const uint64 Limit = static_cast<uint64>(std::numeric_limits<int64>::max()) + (bNegative ? 1 : 0);
+			if (Result.ec == std::errc::result_out_of_range || Value > Limit)
+			{
+				ScanResult = ENumberScanResult::OutOfRange;
+				Value = Limit;
+			}
+			OutToken.SetConstInt64(bNegative ? static_cast<int64>(0 - Value) : static_cast<int64>(Value));
+		}
+		OutLength = Cursor - Begin;
+		return ScanResult;
+	}
+}
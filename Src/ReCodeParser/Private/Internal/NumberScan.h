@@ -0,0 +1,25 @@
+#pragma once
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	class Token;
+
+	enum class ENumberScanResult : uint8
+	{
+		Ok,
+		// no number at the scan position
+		NotANumber,
+		// the literal does not fit its type, the token holds the saturated value
+		OutOfRange,
+	};
+
+	/**
+	 * Scans a number constant in place with std::from_chars and sets the token value.
+	 * Accepts an optional sign, decimal and 0x hex integers, and floating point with a fraction and/or exponent.
+	 * A floating point literal with an f/F suffix becomes Float, without it Double; integers become Int64.
+	 *
+	 * @param	OutLength	chars consumed, suffix included
+	 */
+	ENumberScanResult ScanNumber(const char* Begin, const char* End, Token& OutToken, int64& OutLength);
+}
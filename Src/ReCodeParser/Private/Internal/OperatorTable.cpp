@@ -0,0 +1,75 @@
+#include "OperatorTable.h"
+
+#include <algorithm>
+
+namespace ReParser
+{
+	OperatorTable::OperatorTable(const Re::Vector<Re::String>& InOperators)
+	{
+		Next.assign(RowSize, 0);
+		Ids.assign(1, 0);
+		for (const Re::String& Operator : InOperators)
+		{
+			if (Operator.size() < 2
+				|| std::any_of(Operator.begin(), Operator.end(), [](char c) { return static_cast<uint8>(c) >= RowSize; })
+				|| std::find(Operators.begin(), Operators.end(), Operator) != Operators.end())
+			{
+				continue;
+			}
+			Operators.push_back(Operator);
+
+			int32 Node = 0;
+			for (const char c : Operator)
+			{
+				int32& Child = Next[Node * RowSize + c];
+				if (Child == 0)
+				{
+					Child = static_cast<int32>(Ids.size());
+					Ids.push_back(0);
+					Next.resize(Next.size() + RowSize, 0);
+				}
+				// Next may have grown, index it again instead of keeping the reference
+				Node = Next[Node * RowSize + c];
+			}
+			Ids[Node] = FirstOperatorId + static_cast<int32>(Operators.size()) - 1;
+		}
+	}
+
+	const Re::SharedPtr<const OperatorTable>& OperatorTable::Default()
+	{
+		static const Re::SharedPtr<const OperatorTable> Table = Re::MakeShared<OperatorTable>(Re::Vector<Re::String>{
+			"<<", ">>", ">>>", "!=", "<=", ">=", "++", "--", "+=", "-=", "*=", "/=", "&&", "||", "^^", "==", "**", "~=", "::" });
+		return Table;
+	}
+
+	int32 OperatorTable::Find(std::string_view Symbol) const
+	{
+		if (Symbol.size() == 1)
+		{
+			return static_cast<uint8>(Symbol[0]);
+		}
+		int32 Node = 0;
+		for (const char c : Symbol)
+		{
+			if (static_cast<uint8>(c) >= RowSize)
+			{
+				return 0;
+			}
+			Node = Next[Node * RowSize + c];
+			if (Node == 0)
+			{
+				return 0;
+			}
+		}
+		return Ids[Node];
+	}
+
+	Re::String OperatorTable::GetSymbol(int32 Id) const
+	{
+		if (Id > 0 && Id < FirstOperatorId)
+		{
+			return Re::String(1, static_cast<char>(Id));
+		}
+		return Operators[Id - FirstOperatorId];
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <string_view>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * Multi-character operators of a parser compiled into a trie, the lexer takes the longest
+	 * operator at the input position. Every symbol token carries a symbol id: the char code for
+	 * a single char symbol, FirstOperatorId + declaration index for a multi-character operator.
+	 */
+	class RECODEPARSER_API OperatorTable
+	{
+	public:
+		static constexpr int32 FirstOperatorId = 256;
+
+		/** Operators of 2 chars or more made of ASCII chars, single chars are always symbols. */
+		explicit OperatorTable(const Re::Vector<Re::String>& InOperators);
+
+		/** Operators BaseParser has always lexed: << >> >>> != <= >= ++ -- += -= *= /= && || ^^ == ** ~= :: */
+		static const Re::SharedPtr<const OperatorTable>& Default();
+
+		/**
+		 * Finds the longest operator at Pos, a single char symbol when none matches.
+		 *
+		 * @return the symbol id, OutLength is set to the length of the symbol.
+		 */
+		int32 Match(const char* Text, int64 Pos, int64 Len, int32& OutLength) const
+		{
+			int32 Id = static_cast<uint8>(Text[Pos]);
+			OutLength = 1;
+			int32 Node = 0;
+			for (int64 i = Pos; i < Len; i++)
+			{
+				const uint8 c = static_cast<uint8>(Text[i]);
+				if (c >= RowSize)
+				{
+					break;
+				}
+				Node = Next[Node * RowSize + c];
+				if (Node == 0)
+				{
+					break;
+				}
+				if (Ids[Node] != 0)
+				{
+					Id = Ids[Node];
+					OutLength = static_cast<int32>(i - Pos + 1);
+				}
+			}
+			return Id;
+		}
+
+		/** @return the symbol id of the exact symbol text, 0 when it is not a symbol of this table. */
+		int32 Find(std::string_view Symbol) const;
+
+		/** Text of a symbol id. */
+		Re::String GetSymbol(int32 Id) const;
+
+		int32 Num() const { return static_cast<int32>(Operators.size()); }
+
+	private:
+		// operator chars are ASCII, a trie row covers them
+		static constexpr int32 RowSize = 128;
+
+		Re::Vector<Re::String> Operators;
+		// Node * RowSize + char -> child node, 0 when there is none since the root is never a child
+		Re::Vector<int32> Next;
+		// symbol id of the operator ending at a node, 0 for none
+		Re::Vector<int32> Ids;
+	};
+}
@@ -0,0 +1,518 @@
+#include "ScanKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RE_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define RE_SCAN_AVX2_TARGET
+#else
+#define RE_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define RE_SCAN_X86 0
+#endif
+
+namespace ReParser::Scan
+{
+	namespace
+	{
+		bool IsWhitespaceChar(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+
+		bool IsIdentifierChar(char c)
+		{
+			return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || static_cast<uint8>(c) >= 0x80;
+		}
+
+		bool IsLineEndChar(char c)
+		{
+			return c == '\n' || c == '\r' || c == 0;
+		}
+
+		bool IsStringStopChar(char c)
+		{
+			return c == '"' || c == '\\' || IsLineEndChar(c);
+		}
+
+		const char* SkipWhitespaceScalar(const char* Pos, const char* End, int32& OutNewlines)
+		{
+			for (; Pos < End && IsWhitespaceChar(*Pos); Pos++)
+			{
+				OutNewlines += *Pos == '\n';
+			}
+			return Pos;
+		}
+
+		const char* FindLineEndScalar(const char* Pos, const char* End)
+		{
+			while (Pos < End && !IsLineEndChar(*Pos))
+			{
+				Pos++;
+			}
+			return Pos;
+		}
+
+		const char* FindIdentifierEndScalar(const char* Pos, const char* End, bool& bOutNonAscii)
+		{
+			uint8 Bits = 0;
+			for (; Pos < End && IsIdentifierChar(*Pos); Pos++)
+			{
+				Bits |= static_cast<uint8>(*Pos);
+			}
+			bOutNonAscii |= Bits >= 0x80;
+			return Pos;
+		}
+
+		// length of the well-formed UTF-8 sequence at Pos, 0 if it is ill-formed, see table 3-7 of the Unicode standard
+		int32 GetUtf8SequenceLength(const char* Pos, const char* End)
+		{
+			const uint8 Lead = static_cast<uint8>(*Pos);
+			if (Lead < 0x80)
+			{
+				return 1;
+			}
+			int32 Length = 0;
+			uint8 Low = 0x80;
+			uint8 High = 0xBF;
+			if (Lead >= 0xC2 && Lead <= 0xDF)
+			{
+				Length = 2;
+			}
+			else if (Lead >= 0xE0 && Lead <= 0xEF)
+			{
+				Length = 3;
+				// no overlong forms, no surrogates
+				Low = Lead == 0xE0 ? 0xA0 : Low;
+				High = Lead == 0xED ? 0x9F : High;
+			}
+			else if (Lead >= 0xF0 && Lead <= 0xF4)
+			{
+				Length = 4;
+				// no overlong forms, nothing above U+10FFFF
+				Low = Lead == 0xF0 ? 0x90 : Low;
+				High = Lead == 0xF4 ? 0x8F : High;
+			}
+			if (Length == 0 || End - Pos < Length)
+			{
+				return 0;
+			}
+			const uint8 Second = static_cast<uint8>(Pos[1]);
+			if (Second < Low || Second > High)
+			{
+				return 0;
+			}
+			for (int32 i = 2; i < Length; i++)
+			{
+				if ((static_cast<uint8>(Pos[i]) & 0xC0) != 0x80)
+				{
+					return 0;
+				}
+			}
+			return Length;
+		}
+
+		const char* FindInvalidUtf8Scalar(const char* Pos, const char* End)
+		{
+			while (Pos < End)
+			{
+				const int32 Length = GetUtf8SequenceLength(Pos, End);
+				if (Length == 0)
+				{
+					return Pos;
+				}
+				Pos += Length;
+			}
+			return End;
+		}
+
+		const char* FindStringStopScalar(const char* Pos, const char* End)
+		{
+			while (Pos < End && !IsStringStopChar(*Pos))
+			{
+				Pos++;
+			}
+			return Pos;
+		}
+
+		void AppendLineStartsScalar(const char* Begin, const char* Pos, const char* End, Re::Vector<int64>& OutLineStarts)
+		{
+			for (; Pos < End; Pos++)
+			{
+				if (*Pos == '\n')
+				{
+					OutLineStarts.push_back(Pos - Begin + 1);
+				}
+			}
+		}
+
+#if RE_SCAN_X86
+
+		int32 CountTrailingZeros(uint32 Mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long Index;
+			_BitScanForward(&Index, Mask);
+			return static_cast<int32>(Index);
+#else
+			return __builtin_ctz(Mask);
+#endif
+		}
+
+		int32 PopCount(uint32 Mask)
+		{
+			Mask = Mask - ((Mask >> 1) & 0x55555555u);
+			Mask = (Mask & 0x33333333u) + ((Mask >> 2) & 0x33333333u);
+			return static_cast<int32>((((Mask + (Mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+		}
+
+		// validates whole sequences until Pos reaches Until, the last one may run past it
+		const char* ValidateUtf8Until(const char* Pos, const char* Until, const char* End)
+		{
+			while (Pos < Until)
+			{
+				const int32 Length = GetUtf8SequenceLength(Pos, End);
+				if (Length == 0)
+				{
+					return nullptr;
+				}
+				Pos += Length;
+			}
+			return Pos;
+		}
+
+		// signed byte compares are enough, every range below is plain ASCII
+		__m128i InRange16(__m128i V, char Low, char High)
+		{
+			return _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8(static_cast<char>(Low - 1))), _mm_cmplt_epi8(V, _mm_set1_epi8(static_cast<char>(High + 1))));
+		}
+
+		const char* SkipWhitespaceSSE2(const char* Pos, const char* End, int32& OutNewlines)
+		{
+			for (; End - Pos >= 16; Pos += 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				const __m128i Newline = _mm_cmpeq_epi8(V, _mm_set1_epi8('\n'));
+				const __m128i Blank = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\t'))),
+					_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\r')), Newline));
+				const uint32 Stop = ~static_cast<uint32>(_mm_movemask_epi8(Blank)) & 0xFFFFu;
+				const uint32 Newlines = static_cast<uint32>(_mm_movemask_epi8(Newline));
+				if (Stop != 0)
+				{
+					const int32 Index = CountTrailingZeros(Stop);
+					OutNewlines += PopCount(Newlines & ((1u << Index) - 1));
+					return Pos + Index;
+				}
+				OutNewlines += PopCount(Newlines);
+			}
+			return SkipWhitespaceScalar(Pos, End, OutNewlines);
+		}
+
+		const char* FindLineEndSSE2(const char* Pos, const char* End)
+		{
+			for (; End - Pos >= 16; Pos += 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				const __m128i Hit = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\r'))),
+					_mm_cmpeq_epi8(V, _mm_setzero_si128()));
+				const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(Hit));
+				if (Mask != 0)
+				{
+					return Pos + CountTrailingZeros(Mask);
+				}
+			}
+			return FindLineEndScalar(Pos, End);
+		}
+
+		const char* FindIdentifierEndSSE2(const char* Pos, const char* End, bool& bOutNonAscii)
+		{
+			for (; End - Pos >= 16; Pos += 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				const __m128i Letter = InRange16(_mm_or_si128(V, _mm_set1_epi8(0x20)), 'a', 'z');
+				const __m128i Digit = InRange16(V, '0', '9');
+				const __m128i Underscore = _mm_cmpeq_epi8(V, _mm_set1_epi8('_'));
+				const __m128i Part = _mm_or_si128(_mm_or_si128(Letter, Digit), Underscore);
+				// the sign bit of V marks the non-ASCII bytes
+				const uint32 NonAscii = static_cast<uint32>(_mm_movemask_epi8(V));
+				const uint32 Stop = ~(static_cast<uint32>(_mm_movemask_epi8(Part)) | NonAscii) & 0xFFFFu;
+				if (Stop != 0)
+				{
+					bOutNonAscii |= (NonAscii & (Stop - 1) & ~Stop) != 0;
+					return Pos + CountTrailingZeros(Stop);
+				}
+				bOutNonAscii |= NonAscii != 0;
+			}
+			return FindIdentifierEndScalar(Pos, End, bOutNonAscii);
+		}
+
+		const char* FindStringStopSSE2(const char* Pos, const char* End)
+		{
+			for (; End - Pos >= 16; Pos += 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				const __m128i Quote = _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('"')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\\')));
+				const __m128i LineEnd = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\r'))),
+					_mm_cmpeq_epi8(V, _mm_setzero_si128()));
+				const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(_mm_or_si128(Quote, LineEnd)));
+				if (Mask != 0)
+				{
+					return Pos + CountTrailingZeros(Mask);
+				}
+			}
+			return FindStringStopScalar(Pos, End);
+		}
+
+		const char* FindInvalidUtf8SSE2(const char* Pos, const char* End)
+		{
+			while (End - Pos >= 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(V));
+				if (Mask == 0)
+				{
+					Pos += 16;
+					continue;
+				}
+				const char* Next = ValidateUtf8Until(Pos + CountTrailingZeros(Mask), Pos + 16, End);
+				if (Next == nullptr)
+				{
+					return FindInvalidUtf8Scalar(Pos, End);
+				}
+				Pos = Next;
+			}
+			return FindInvalidUtf8Scalar(Pos, End);
+		}
+
+		void AppendLineStartsSSE2(const char* Begin, const char* Pos, const char* End, Re::Vector<int64>& OutLineStarts)
+		{
+			for (; End - Pos >= 16; Pos += 16)
+			{
+				const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pos));
+				uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n'))));
+				const int64 Offset = Pos - Begin + 1;
+				for (; Mask != 0; Mask &= Mask - 1)
+				{
+					OutLineStarts.push_back(Offset + CountTrailingZeros(Mask));
+				}
+			}
+			AppendLineStartsScalar(Begin, Pos, End, OutLineStarts);
+		}
+
+		RE_SCAN_AVX2_TARGET __m256i InRange32(__m256i V, char Low, char High)
+		{
+			return _mm256_and_si256(_mm256_cmpgt_epi8(V, _mm256_set1_epi8(static_cast<char>(Low - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(High + 1)), V));
+		}
+
+		RE_SCAN_AVX2_TARGET const char* SkipWhitespaceAVX2(const char* Pos, const char* End, int32& OutNewlines)
+		{
+			for (; End - Pos >= 32; Pos += 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				const __m256i Newline = _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n'));
+				const __m256i Blank = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\t'))),
+					_mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\r')), Newline));
+				const uint32 Stop = ~static_cast<uint32>(_mm256_movemask_epi8(Blank));
+				const uint32 Newlines = static_cast<uint32>(_mm256_movemask_epi8(Newline));
+				if (Stop != 0)
+				{
+					const int32 Index = CountTrailingZeros(Stop);
+					OutNewlines += PopCount(Index == 32 ? Newlines : Newlines & ((1u << Index) - 1));
+					return Pos + Index;
+				}
+				OutNewlines += PopCount(Newlines);
+			}
+			return SkipWhitespaceSSE2(Pos, End, OutNewlines);
+		}
+
+		RE_SCAN_AVX2_TARGET const char* FindLineEndAVX2(const char* Pos, const char* End)
+		{
+			for (; End - Pos >= 32; Pos += 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				const __m256i Hit = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\r'))),
+					_mm256_cmpeq_epi8(V, _mm256_setzero_si256()));
+				const uint32 Mask = static_cast<uint32>(_mm256_movemask_epi8(Hit));
+				if (Mask != 0)
+				{
+					return Pos + CountTrailingZeros(Mask);
+				}
+			}
+			return FindLineEndSSE2(Pos, End);
+		}
+
+		RE_SCAN_AVX2_TARGET const char* FindIdentifierEndAVX2(const char* Pos, const char* End, bool& bOutNonAscii)
+		{
+			for (; End - Pos >= 32; Pos += 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				const __m256i Letter = InRange32(_mm256_or_si256(V, _mm256_set1_epi8(0x20)), 'a', 'z');
+				const __m256i Digit = InRange32(V, '0', '9');
+				const __m256i Underscore = _mm256_cmpeq_epi8(V, _mm256_set1_epi8('_'));
+				const __m256i Part = _mm256_or_si256(_mm256_or_si256(Letter, Digit), Underscore);
+				const uint32 NonAscii = static_cast<uint32>(_mm256_movemask_epi8(V));
+				const uint32 Stop = ~(static_cast<uint32>(_mm256_movemask_epi8(Part)) | NonAscii);
+				if (Stop != 0)
+				{
+					bOutNonAscii |= (NonAscii & (Stop - 1) & ~Stop) != 0;
+					return Pos + CountTrailingZeros(Stop);
+				}
+				bOutNonAscii |= NonAscii != 0;
+			}
+			return FindIdentifierEndSSE2(Pos, End, bOutNonAscii);
+		}
+
+		RE_SCAN_AVX2_TARGET const char* FindStringStopAVX2(const char* Pos, const char* End)
+		{
+			for (; End - Pos >= 32; Pos += 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				const __m256i Quote = _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\\')));
+				const __m256i LineEnd = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\r'))),
+					_mm256_cmpeq_epi8(V, _mm256_setzero_si256()));
+				const uint32 Mask = static_cast<uint32>(_mm256_movemask_epi8(_mm256_or_si256(Quote, LineEnd)));
+				if (Mask != 0)
+				{
+					return Pos + CountTrailingZeros(Mask);
+				}
+			}
+			return FindStringStopSSE2(Pos, End);
+		}
+
+		RE_SCAN_AVX2_TARGET const char* FindInvalidUtf8AVX2(const char* Pos, const char* End)
+		{
+			while (End - Pos >= 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				const uint32 Mask = static_cast<uint32>(_mm256_movemask_epi8(V));
+				if (Mask == 0)
+				{
+					Pos += 32;
+					continue;
+				}
+				const char* Next = ValidateUtf8Until(Pos + CountTrailingZeros(Mask), Pos + 32, End);
+				if (Next == nullptr)
+				{
+					return FindInvalidUtf8Scalar(Pos, End);
+				}
+				Pos = Next;
+			}
+			return FindInvalidUtf8SSE2(Pos, End);
+		}
+
+		RE_SCAN_AVX2_TARGET void AppendLineStartsAVX2(const char* Begin, const char* Pos, const char* End, Re::Vector<int64>& OutLineStarts)
+		{
+			for (; End - Pos >= 32; Pos += 32)
+			{
+				const __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Pos));
+				uint32 Mask = static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n'))));
+				const int64 Offset = Pos - Begin + 1;
+				for (; Mask != 0; Mask &= Mask - 1)
+				{
+					OutLineStarts.push_back(Offset + CountTrailingZeros(Mask));
+				}
+			}
+			AppendLineStartsSSE2(Begin, Pos, End, OutLineStarts);
+		}
+
+		bool HasAVX2()
+		{
+#if defined(_MSC_VER)
+			int Info[4];
+			__cpuid(Info, 0);
+			if (Info[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(Info, 1);
+			const bool bOSXSave = (Info[2] & (1 << 27)) != 0;
+			const bool bAVX = (Info[2] & (1 << 28)) != 0;
+			if (!bOSXSave || !bAVX || (_xgetbv(0) & 6) != 6)
+			{
+				return false;
+			}
+			__cpuidex(Info, 7, 0);
+			return (Info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+
+#endif
+
+		struct KernelSet
+		{
+			const char* Name;
+			const char* (*SkipWhitespace)(const char*, const char*, int32&);
+			const char* (*FindLineEnd)(const char*, const char*);
+			const char* (*FindIdentifierEnd)(const char*, const char*, bool&);
+			const char* (*FindStringStop)(const char*, const char*);
+			const char* (*FindInvalidUtf8)(const char*, const char*);
+			void (*AppendLineStarts)(const char*, const char*, const char*, Re::Vector<int64>&);
+		};
+
+		KernelSet SelectKernels()
+		{
+#if RE_SCAN_X86
+			if (HasAVX2())
+			{
+				return { "AVX2", &SkipWhitespaceAVX2, &FindLineEndAVX2, &FindIdentifierEndAVX2, &FindStringStopAVX2, &FindInvalidUtf8AVX2, &AppendLineStartsAVX2 };
+			}
+			return { "SSE2", &SkipWhitespaceSSE2, &FindLineEndSSE2, &FindIdentifierEndSSE2, &FindStringStopSSE2, &FindInvalidUtf8SSE2, &AppendLineStartsSSE2 };
+#else
+			return { "Scalar", &SkipWhitespaceScalar, &FindLineEndScalar, &FindIdentifierEndScalar, &FindStringStopScalar, &FindInvalidUtf8Scalar, &AppendLineStartsScalar };
+#endif
+		}
+
+		// picked on first use, a lexer may run from the static initializer of another file
+		const KernelSet& GetKernels()
+		{
+			static const KernelSet Kernels = SelectKernels();
+			return Kernels;
+		}
+	}
+
+	const char* SkipWhitespace(const char* Pos, const char* End, int32& OutNewlines)
+	{
+		return GetKernels().SkipWhitespace(Pos, End, OutNewlines);
+	}
+
+	const char* FindLineEnd(const char* Pos, const char* End)
+	{
+		return GetKernels().FindLineEnd(Pos, End);
+	}
+
+	const char* FindIdentifierEnd(const char* Pos, const char* End, bool& bOutNonAscii)
+	{
+		return GetKernels().FindIdentifierEnd(Pos, End, bOutNonAscii);
+	}
+
+	const char* FindStringStop(const char* Pos, const char* End)
+	{
+		return GetKernels().FindStringStop(Pos, End);
+	}
+
+	const char* FindInvalidUtf8(const char* Pos, const char* End)
+	{
+		return GetKernels().FindInvalidUtf8(Pos, End);
+	}
+
+	void AppendLineStarts(const char* Begin, const char* Pos, const char* End, Re::Vector<int64>& OutLineStarts)
+	{
+		GetKernels().AppendLineStarts(Begin, Pos, End, OutLineStarts);
+	}
+
+	const char* GetKernelName()
+	{
+		return GetKernels().Name;
+	}
+}
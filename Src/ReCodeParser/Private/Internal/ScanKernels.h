@@ -0,0 +1,31 @@
+#pragma once
+#include "ReCppCommon.h"
+
+/**
+ * Bulk scanning kernels for the lexer hot loops.
+ * Every kernel scans [Pos, End) and returns the first position that stops the scan, End if none does.
+ * SSE2 and AVX2 versions are picked at runtime, other targets use the scalar fallback.
+ */
+namespace ReParser::Scan
+{
+	/** Skips ' ', '\t', '\r' and '\n', OutNewlines receives the number of '\n' skipped. */
+	const char* SkipWhitespace(const char* Pos, const char* End, int32& OutNewlines);
+
+	/** Finds the next '\n', '\r' or '\0'. */
+	const char* FindLineEnd(const char* Pos, const char* End);
+
+	/** Finds the first char outside [A-Za-z0-9_] and the non-ASCII bytes of UTF-8 identifiers, bOutNonAscii is set when it skipped any of the latter. */
+	const char* FindIdentifierEnd(const char* Pos, const char* End, bool& bOutNonAscii);
+
+	/** Finds the next '"', '\\', '\n', '\r' or '\0' inside a string literal. */
+	const char* FindStringStop(const char* Pos, const char* End);
+
+	/** Finds the first byte of the first ill-formed UTF-8 sequence, a sequence cut short by End is ill-formed. */
+	const char* FindInvalidUtf8(const char* Pos, const char* End);
+
+	/** Appends the offset from Begin of the char after every '\n' in [Pos, End) to OutLineStarts, scans the whole range. */
+	void AppendLineStarts(const char* Begin, const char* Pos, const char* End, Re::Vector<int64>& OutLineStarts);
+
+	/** Name of the kernel set selected for this CPU. */
+	const char* GetKernelName();
+}
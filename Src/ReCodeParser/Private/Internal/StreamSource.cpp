@@ -0,0 +1,104 @@
+#include "StreamSource.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ReParser
+{
+	void StreamSource::Open(ReaderFunc InReader, int64 InChunkSize)
+	{
+		Close();
+		Reader = std::move(InReader);
+		ChunkSize = std::max<int64>(InChunkSize, 1);
+		bAtEnd = false;
+	}
+
+	void StreamSource::Open(int FileDescriptor, int64 InChunkSize)
+	{
+		Open([FileDescriptor](char* Buffer, int64 Capacity) -> int64
+		{
+			for (;;)
+			{
+#if defined(_WIN32)
+				const int64 Count = _read(FileDescriptor, Buffer, static_cast<unsigned int>(std::min<int64>(Capacity, INT_MAX)));
+#else
+				const int64 Count = read(FileDescriptor, Buffer, static_cast<size_t>(Capacity));
+#endif
+				if (Count >= 0 || errno != EINTR)
+				{
+					return Count;
+				}
+			}
+		}, InChunkSize);
+	}
+
+	void StreamSource::Close()
+	{
+		Reader = nullptr;
+		Window.reset();
+		Retired.clear();
+		Capacity = 0;
+		WindowBegin = 0;
+		WindowEnd = 0;
+		bAtEnd = true;
+		bFailed = false;
+	}
+
+	const char* StreamSource::Fill(int64 KeepPos, int64 MinEnd, int64& OutEnd)
+	{
+		KeepPos = std::clamp(KeepPos, WindowBegin, WindowEnd);
+		if (!bAtEnd && MinEnd - WindowBegin > Capacity)
+		{
+			// move the kept text to a window with room for MinEnd, twice the size so the next moves stay rare
+			const int64 Kept = WindowEnd - KeepPos;
+			const int64 NewCapacity = std::max(MinEnd - KeepPos, ChunkSize) * 2;
+			std::unique_ptr<char[]> NewWindow{ new char[static_cast<size_t>(NewCapacity)] };
+			if (Kept > 0)
+			{
+				std::memcpy(NewWindow.get(), Window.get() + (KeepPos - WindowBegin), static_cast<size_t>(Kept));
+			}
+			if (Window)
+			{
+				Retired.push_back(std::move(Window));
+			}
+			Window = std::move(NewWindow);
+			Capacity = NewCapacity;
+			WindowBegin = KeepPos;
+		}
+
+		while (!bAtEnd && WindowEnd < MinEnd)
+		{
+			const int64 Room = Capacity - (WindowEnd - WindowBegin);
+			const int64 Count = Reader(Window.get() + (WindowEnd - WindowBegin), std::min(Room, ChunkSize));
+			if (Count <= 0)
+			{
+				bAtEnd = true;
+				bFailed = Count < 0;
+				break;
+			}
+			WindowEnd += Count;
+		}
+		OutEnd = WindowEnd;
+		return GetBase();
+	}
+
+	void StreamSource::ReleaseRetired()
+	{
+		Retired.clear();
+	}
+
+	const char* StreamSource::GetBase() const
+	{
+		// offsets stay absolute for the lexer and the tokens, only [WindowBegin, WindowEnd) is ever read through the base
+		return reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(Window.get()) - static_cast<uintptr_t>(WindowBegin));
+	}
+}
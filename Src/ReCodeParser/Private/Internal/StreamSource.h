@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * Source pulled in fixed-size chunks from a reader, so inputs larger than memory parse
+	 * with a bounded buffer. The window holds the text from the oldest position the parser may
+	 * still go back to up to what was read so far. A window that has to move is retired instead
+	 * of freed, tokens lexed from it stay readable until ReleaseRetired.
+	 */
+	class RECODEPARSER_API StreamSource
+	{
+	public:
+		/** Fills Buffer with at most Capacity chars, returns the count, 0 at the end of the stream and < 0 on error. */
+		using ReaderFunc = Re::Func<int64(char* Buffer, int64 Capacity)>;
+
+		static constexpr int64 DefaultChunkSize = 64 * 1024;
+
+		void Open(ReaderFunc InReader, int64 InChunkSize = DefaultChunkSize);
+
+		/** Reads an open file descriptor to its end, the caller keeps owning it. */
+		void Open(int FileDescriptor, int64 InChunkSize = DefaultChunkSize);
+
+		void Close();
+
+		/**
+		 * Reads chunks until the window reaches MinEnd or the stream ends, the text before KeepPos may be dropped.
+		 *
+		 * @return base of the window, Base + Offset is the char at the absolute Offset, OutEnd receives the end of the text read.
+		 */
+		const char* Fill(int64 KeepPos, int64 MinEnd, int64& OutEnd);
+
+		/** Frees the retired windows, no token may point into them anymore. */
+		void ReleaseRetired();
+
+		bool IsOpen() const { return static_cast<bool>(Reader); }
+		bool IsAtEnd() const { return bAtEnd; }
+		bool HasFailed() const { return bFailed; }
+		int64 GetChunkSize() const { return ChunkSize; }
+		int64 GetWindowBegin() const { return WindowBegin; }
+		int64 GetCapacity() const { return Capacity; }
+
+	private:
+		const char* GetBase() const;
+
+		ReaderFunc Reader;
+		int64 ChunkSize = DefaultChunkSize;
+		std::unique_ptr<char[]> Window;
+		int64 Capacity = 0;
+		// absolute offsets of the first char of the window and of the end of the text read
+		int64 WindowBegin = 0;
+		int64 WindowEnd = 0;
+		Re::Vector<std::unique_ptr<char[]>> Retired;
+		bool bAtEnd = true;
+		bool bFailed = false;
+	};
+}
@@ -2,13 +2,109 @@
 
 namespace ReParser
 {
+	static void AppendUtf8(Re::String& Out, uint32 CodePoint)
+	{
+		if (CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+		{
+			// the lexer reported it, U+FFFD stands in
+			CodePoint = 0xFFFD;
+		}
+		if (CodePoint < 0x80)
+		{
+			Out += static_cast<char>(CodePoint);
+		}
+		else if (CodePoint < 0x800)
+		{
+			Out += static_cast<char>(0xC0 | (CodePoint >> 6));
+			Out += static_cast<char>(0x80 | (CodePoint & 0x3F));
+		}
+		else if (CodePoint < 0x10000)
+		{
+			Out += static_cast<char>(0xE0 | (CodePoint >> 12));
+			Out += static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+			Out += static_cast<char>(0x80 | (CodePoint & 0x3F));
+		}
+		else
+		{
+			Out += static_cast<char>(0xF0 | (CodePoint >> 18));
+			Out += static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F));
+			Out += static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+			Out += static_cast<char>(0x80 | (CodePoint & 0x3F));
+		}
+	}
+
+	static int32 GetHexDigitValue(char c)
+	{
+		if (c >= '0' && c <= '9')
+		{
+			return c - '0';
+		}
+		c = static_cast<char>(c | 0x20);
+		return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+	}
+
+	static Re::String UnescapeString(std::string_view Raw)
+	{
+		Re::String Result;
+		Result.reserve(Raw.size());
+		for (size_t i = 0; i < Raw.size(); i++)
+		{
+			char c = Raw[i];
+			if (c == '\\' && i + 1 < Raw.size())
+			{
+				c = Raw[++i];
+				switch (c)
+				{
+				case 'n':
+					c = '\n';
+					break;
+				case 't':
+					c = '\t';
+					break;
+				case 'r':
+					c = '\r';
+					break;
+				case 'x':
+				case 'u':
+				case 'U':
+				{
+					// \xNN is a byte, \uXXXX and \UXXXXXXXX are code points stored as UTF-8
+					const size_t MaxDigits = c == 'x' ? 2 : c == 'u' ? 4 : 8;
+					uint32 Value = 0;
+					size_t Digits = 0;
+					for (; Digits < MaxDigits && i + 1 < Raw.size() && GetHexDigitValue(Raw[i + 1]) >= 0; Digits++)
+					{
+						Value = Value * 16 + static_cast<uint32>(GetHexDigitValue(Raw[++i]));
+					}
+					if (Digits == 0)
+					{
+						break;
+					}
+					if (c == 'x')
+					{
+						c = static_cast<char>(Value);
+						break;
+					}
+					AppendUtf8(Result, Value);
+					continue;
+				}
+				default:
+					break;
+				}
+			}
+			Result += c;
+		}
+		return Result;
+	}
+
 	void Token::InitToken()
 	{
 		TokenType = ETokenType::None;
+		ConstType = ETokenConstType::None;
 		StartPos = 0;
-		StartLine = 0;
-		*Identifier = 0;
-		std::memset(Value.String, 0, sizeof(Value.String));
+		Length = 0;
+		TerminalId = 0;
+		Value.Int64 = 0;
 	}
 
 	Re::String Token::GetTokenName() const
@@ -18,15 +114,10 @@ namespace ReParser
 			return GetConstantValue();
 		}else
 		{
-			return Re::String{Identifier};
+			return Re::String{GetTokenView()};
 		}
 	}
 
-	const char* Token::GetRawTokenName() const
-	{
-		return Identifier;
-	}
-
 	Re::String Token::GetConstantValue() const
 	{
 		if(TokenType == ETokenType::Const)
@@ -46,7 +137,7 @@ namespace ReParser
 			case ETokenConstType::Double:
 				return std::to_string(Value.Double);
 			case ETokenConstType::String:
-				return Value.String;
+				return UnescapeString(GetStringView());
 			case ETokenConstType::Nullptr:
 				return "nullptr";
 			default:
@@ -1,9 +1,10 @@
 #pragma once
+#include <string_view>
 #include "ReCppCommon.h"
 
 namespace ReParser
 {
-	enum class ETokenType
+	enum class ETokenType : uint8
 	{
 		None = 0,
 		Identifier,
@@ -12,7 +13,7 @@ namespace ReParser
 		Max
 	};
 
-	enum class ETokenConstType
+	enum class ETokenConstType : uint8
 	{
 		None,
 		Byte,
@@ -25,39 +26,55 @@ namespace ReParser
 		Nullptr
 	};
 
+	/**
+	 * A lexed token. Tokens do not own any text, they only keep a span into the
+	 * parser input, so the input buffer must outlive every token copied out of the parser.
+	 */
 	class Token final
 	{
 		friend class BaseParser;
-
-	public:
-		constexpr static int32 NameSize = 1024;
-		constexpr static int32 MaxStringConstSize = 1024;
+		friend class DFALexer;
+		friend class TokenArray;
 
 	private:
-		// Token Type
-		ETokenType TokenType = ETokenType::None;
-
-		// Token Position
-		int32 StartPos = 0;
-		int32 StartLine = 1;
-		// Token Identifier String
-		char Identifier[NameSize]{};
+		// Input buffer the token span points into
+		const char* Source = nullptr;
 
+		// Token Position, offsets are 64-bit so inputs over 2 GB work, a single token stays below
+		int64 StartPos = 0;
+		int32 Length = 0;
 
+		// Token Type
+		ETokenType TokenType = ETokenType::None;
 
 	public:
 		// Storage for Const
 		ETokenConstType ConstType = ETokenConstType::None;
+
+	private:
+		// Pattern index + 1 of a token lexed by a DFALexer, 0 for the built-in lexer
+		uint16 TerminalId = 0;
+
+	public:
 		union ConstContent
 		{
 			// TOKEN_Const values.
-			uint8 Byte{};							// If CPT_Byte.
-			int64 Int64;							// If CPT_Int64.
+			uint8 Byte;								// If CPT_Byte.
+			int64 Int64{};							// If CPT_Int64.
 			int32 Int;								// If CPT_Int.
 			bool NativeBool;						// if CPT_Bool
 			float Float;							// If CPT_Float.
 			double Double;							// If CPT_Double.
-			char String[MaxStringConstSize];		// If CPT_String
+			struct
+			{
+				int32 KeywordId;					// 0 when not a keyword.
+				int32 AtomId;						// 0 when the parser does not intern.
+			} Identifier;							// If Identifier.
+			struct
+			{
+				int32 SymbolId;						// See OperatorTable.
+				int32 AtomId;
+			} Symbol;								// If Symbol.
 		} Value;
 
 	public:
@@ -66,15 +83,10 @@ namespace ReParser
 		{
 			return TokenType == other.TokenType &&
 				ConstType == other.ConstType &&
-				Value.Byte == other.Value.Byte &&
-				Value.Int64 == other.Value.Int64 &&
-				Value.Int == other.Value.Int &&
-				Value.NativeBool == other.Value.NativeBool &&
-				Value.Float == other.Value.Float &&
-				Value.Byte == other.Value.Double &&
-				std::strcmp(Value.String, other.Value.String) == 0 &&
-				std::strcmp(Identifier, other.Identifier) == 0;
-
+				StartPos == other.StartPos &&
+				Length == other.Length &&
+				TerminalId == other.TerminalId &&
+				Value.Int64 == other.Value.Int64;
 		}
 
 		void InitToken();
@@ -82,7 +94,21 @@ namespace ReParser
 		// GetName
 		Re::String GetTokenName() const;
 
-		const char* GetRawTokenName() const;
+		// raw text of the token as written in the input
+		std::string_view GetTokenView() const
+		{
+			return Source ? std::string_view{ Source + StartPos, static_cast<size_t>(Length) } : std::string_view{};
+		}
+
+		// body of a string or char constant without quotes, escapes are not resolved
+		std::string_view GetStringView() const
+		{
+			if (ConstType != ETokenConstType::String || !Source)
+			{
+				return {};
+			}
+			return std::string_view{ Source + StartPos + 1, static_cast<size_t>(Value.Int64) };
+		}
 
 		Re::String GetConstantValue() const;
 
@@ -96,16 +122,53 @@ namespace ReParser
 			return ConstType;
 		}
 
+		int64 GetStartPos() const
+		{
+			return StartPos;
+		}
+
+		int64 GetEndPos() const
+		{
+			return StartPos + Length;
+		}
+
+		// id in the parser KeywordTable, 0 when the token is not a keyword
+		int32 GetKeywordId() const
+		{
+			return TokenType == ETokenType::Identifier ? Value.Identifier.KeywordId : 0;
+		}
+
+		// char code of a single char symbol, an OperatorTable id for longer ones, 0 when not a symbol
+		int32 GetSymbolId() const
+		{
+			return TokenType == ETokenType::Symbol ? Value.Symbol.SymbolId : 0;
+		}
+
+		// id in the parser AtomTable of an identifier or symbol, 0 when not interned
+		int32 GetAtomId() const
+		{
+			if (TokenType == ETokenType::Identifier)
+			{
+				return Value.Identifier.AtomId;
+			}
+			return TokenType == ETokenType::Symbol ? Value.Symbol.AtomId : 0;
+		}
+
+		uint16 GetTerminalId() const
+		{
+			return TerminalId;
+		}
+
 		// match
 		bool Matches(const char Ch) const
 		{
-			return TokenType == ETokenType::Symbol && Identifier[0] == Ch && Identifier[1] == 0;
+			return TokenType == ETokenType::Symbol && Length == 1 && Source[StartPos] == Ch;
 		}
 
 		bool Matches(const char* Str) const
 		{
 			return (TokenType == ETokenType::Identifier || TokenType == ETokenType::Symbol)
-				&& std::strcmp(Identifier, Str) == 0;
+				&& GetTokenView() == Str;
 		}
 
 		bool IsBool() const
@@ -116,11 +179,18 @@ namespace ReParser
 	#pragma region setters
 
 		// setter
-		void SetIdentifier(const char* InString)
+		void SetSpan(const char* InSource, int64 InStartPos, int32 InLength)
+		{
+			Source = InSource;
+			StartPos = InStartPos;
+			Length = InLength;
+		}
+
+		void SetIdentifier(const char* InSource, int64 InStartPos, int32 InLength)
 		{
 			InitToken();
 			TokenType = ETokenType::Identifier;
-			std::strncpy(Identifier, InString, NameSize);
+			SetSpan(InSource, InStartPos, InLength);
 		}
 
 		void SetNullptr()
@@ -164,23 +234,12 @@ namespace ReParser
 			Value.Double = InDouble;
 		}
 
-		void SetConstString(const char* InString, int32 MaxLength = MaxStringConstSize)
+		// string and char constants span their quotes, the body is kept raw and unescaped by GetConstantValue
+		void SetConstString(int32 BodyLength)
 		{
-			RE_ASSERT(MaxLength > 0);
 			ConstType = ETokenConstType::String;
 			TokenType = ETokenType::Const;
-			if(InString != Value.String)
-			{
-				std::memset(Value.String, 0, MaxStringConstSize);
-				std::strncpy(Value.String, InString, MaxLength);
-			}
-		}
-
-		void SetConstChar(char InChar)
-		{
-			Value.String[0] = InChar;
-			Value.String[1] = 0;
-			TokenType = ETokenType::Const;
+			Value.Int64 = BodyLength;
 		}
 
 	#pragma endregion
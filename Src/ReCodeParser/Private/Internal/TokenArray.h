@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include "ReCppCommon.h"
+#include "Token.h"
+
+namespace ReParser
+{
+	/**
+	 * Contiguous array of tokens sorted by input position, filled once by a
+	 * pre-tokenization pass and read back through a cursor.
+	 *
+	 * Edits replace tokens through a gap kept at the last replacement. Tokens behind the gap
+	 * are stored before the edits moved them and shifted when read, so an edit costs the
+	 * tokens it replaces plus the tokens between it and the previous edit.
+	 */
+	class TokenArray final
+	{
+	public:
+		void Reset()
+		{
+			Tokens.clear();
+			GapBegin = 0;
+			GapSize = 0;
+			PosShift = 0;
+			Cursor = 0;
+		}
+
+		void Add(const Token& InToken)
+		{
+			MoveGap(Num());
+			if (GapSize > 0)
+			{
+				Tokens[GapBegin] = InToken;
+				GapSize--;
+			}
+			else
+			{
+				Tokens.push_back(InToken);
+			}
+			GapBegin++;
+		}
+
+		int32 Num() const
+		{
+			return static_cast<int32>(Tokens.size()) - GapSize;
+		}
+
+		Token operator[](int32 Index) const
+		{
+			if (Index < GapBegin)
+			{
+				return Tokens[Index];
+			}
+			Token Result = Tokens[Index + GapSize];
+			Result.StartPos += PosShift;
+			return Result;
+		}
+
+		int64 GetStartPos(int32 Index) const
+		{
+			return Index < GapBegin ? Tokens[Index].StartPos : Tokens[Index + GapSize].StartPos + PosShift;
+		}
+
+		/** Replaces the tokens [First, End) by NewTokens and moves the tokens behind them by PosDelta. */
+		void Replace(int32 First, int32 End, const Re::Vector<Token>& NewTokens, int64 PosDelta)
+		{
+			MoveGap(First);
+			// the replaced tokens are right behind the gap now
+			GapSize += End - First;
+			const int32 NewNum = static_cast<int32>(NewTokens.size());
+			if (NewNum > GapSize)
+			{
+				// grow by a fraction of the array so a run of inserting edits stays amortized
+				const int32 Extra = NewNum - GapSize + std::max(Num() / 16, 64);
+				Tokens.insert(Tokens.begin() + GapBegin + GapSize, static_cast<size_t>(Extra), Token{});
+				GapSize += Extra;
+			}
+			std::copy(NewTokens.begin(), NewTokens.end(), Tokens.begin() + GapBegin);
+			GapBegin += NewNum;
+			GapSize -= NewNum;
+			PosShift += PosDelta;
+			Cursor = 0;
+		}
+
+		/** @return index of the first token starting at or after Pos, Num() if there is none. */
+		int32 LowerBound(int64 Pos) const
+		{
+			int32 Low = 0;
+			int32 High = Num();
+			while (Low < High)
+			{
+				const int32 Middle = Low + (High - Low) / 2;
+				if (GetStartPos(Middle) < Pos)
+				{
+					Low = Middle + 1;
+				}
+				else
+				{
+					High = Middle;
+				}
+			}
+			return Low;
+		}
+
+		/**
+		 * Finds the first token starting at or after Pos and moves the cursor behind it.
+		 * Sequential reads hit the cursor directly, backtracking falls back to a binary search.
+		 *
+		 * @return index of the token, Num() if there is none.
+		 */
+		int32 Seek(int64 Pos)
+		{
+			int32 Index = Cursor;
+			if (!IsFirstAtOrAfter(Index, Pos))
+			{
+				Index = LowerBound(Pos);
+			}
+			Cursor = Index < Num() ? Index + 1 : Index;
+			return Index;
+		}
+
+	private:
+
+		bool IsFirstAtOrAfter(int32 Index, int64 Pos) const
+		{
+			return Index <= Num()
+				&& (Index == Num() || GetStartPos(Index) >= Pos)
+				&& (Index == 0 || GetStartPos(Index - 1) < Pos);
+		}
+
+		/** Moves the gap in front of the token at Index, tokens crossing it take or drop the pending shift. */
+		void MoveGap(int32 Index)
+		{
+			while (GapBegin < Index)
+			{
+				Token& Moved = Tokens[GapBegin] = Tokens[GapBegin + GapSize];
+				Moved.StartPos += PosShift;
+				GapBegin++;
+			}
+			while (GapBegin > Index)
+			{
+				GapBegin--;
+				Token& Moved = Tokens[GapBegin + GapSize] = Tokens[GapBegin];
+				Moved.StartPos -= PosShift;
+			}
+			if (GapBegin == Num())
+			{
+				PosShift = 0;
+			}
+		}
+
+		Re::Vector<Token> Tokens;
+		// logical tokens [0, GapBegin) are stored in place, the others GapSize slots further
+		int32 GapBegin = 0;
+		int32 GapSize = 0;
+		// added to the position of the tokens behind the gap
+		int64 PosShift = 0;
+		int32 Cursor = 0;
+	};
+}
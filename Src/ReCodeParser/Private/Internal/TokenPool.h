@@ -0,0 +1,42 @@
+#pragma once
+#include "ReCppCommon.h"
+#include "Token.h"
+
+namespace ReParser
+{
+	/**
+	 * Chunked arena backing the tokens handed out by BaseParser::GetToken.
+	 * Tokens never move once allocated and are recycled in bulk by Reset,
+	 * chunks are kept alive so steady-state lexing does not touch the heap.
+	 */
+	class TokenPool final
+	{
+	public:
+		constexpr static int32 ChunkSize = 256;
+
+		Token* Allocate()
+		{
+			if (ChunkOffset == ChunkSize)
+			{
+				ChunkIndex++;
+				ChunkOffset = 0;
+			}
+			if (ChunkIndex == static_cast<int32>(Chunks.size()))
+			{
+				Chunks.emplace_back(new Token[ChunkSize]);
+			}
+			return &Chunks[ChunkIndex][ChunkOffset++];
+		}
+
+		void Reset()
+		{
+			ChunkIndex = 0;
+			ChunkOffset = 0;
+		}
+
+	private:
+		Re::Vector<std::unique_ptr<Token[]>> Chunks;
+		int32 ChunkIndex = 0;
+		int32 ChunkOffset = 0;
+	};
+}
@@ -0,0 +1,131 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace ReParser
+{
+	WorkStealingPool::WorkStealingPool(int32 ThreadCount)
+	{
+		if (ThreadCount <= 0)
+		{
+			ThreadCount = std::max(1, static_cast<int32>(std::thread::hardware_concurrency()));
+		}
+		for (int32 i = 0; i < ThreadCount; i++)
+		{
+			Queues.push_back(std::make_unique<WorkQueue>());
+		}
+		// queue 0 belongs to the thread calling ParallelFor
+		for (int32 i = 1; i < ThreadCount; i++)
+		{
+			Threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bStopping = true;
+		}
+		WorkReady.notify_all();
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+	}
+
+	void WorkStealingPool::ParallelFor(int32 Count, const TaskFunc& Task)
+	{
+		if (Count <= 0)
+		{
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			CurrentTask = &Task;
+			PendingCount = Count;
+			// contiguous blocks keep neighbouring indices on one worker until it is stolen from
+			const int32 QueueCount = GetThreadCount();
+			for (int32 i = 0; i < QueueCount; i++)
+			{
+				WorkQueue& Queue = *Queues[static_cast<size_t>(i)];
+				std::lock_guard<std::mutex> QueueLock(Queue.Mutex);
+				const int32 First = static_cast<int32>(static_cast<int64>(Count) * i / QueueCount);
+				const int32 Last = static_cast<int32>(static_cast<int64>(Count) * (i + 1) / QueueCount);
+				for (int32 Index = First; Index < Last; Index++)
+				{
+					Queue.Indices.push_back(Index);
+				}
+			}
+			Generation++;
+		}
+		WorkReady.notify_all();
+
+		RunTasks(0);
+
+		std::unique_lock<std::mutex> Lock(Mutex);
+		WorkDone.wait(Lock, [this]() { return PendingCount == 0; });
+		CurrentTask = nullptr;
+	}
+
+	void WorkStealingPool::WorkerLoop(int32 WorkerIndex)
+	{
+		uint64 SeenGeneration = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				WorkReady.wait(Lock, [&]() { return bStopping || Generation != SeenGeneration; });
+				if (bStopping)
+				{
+					return;
+				}
+				SeenGeneration = Generation;
+			}
+			RunTasks(WorkerIndex);
+		}
+	}
+
+	void WorkStealingPool::RunTasks(int32 WorkerIndex)
+	{
+		int32 Index = 0;
+		while (PopTask(WorkerIndex, Index))
+		{
+			// the task stays alive until PendingCount drops to 0, which cannot happen before this call returns
+			(*CurrentTask)(Index);
+
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (--PendingCount == 0)
+			{
+				WorkDone.notify_all();
+			}
+		}
+	}
+
+	bool WorkStealingPool::PopTask(int32 WorkerIndex, int32& OutIndex)
+	{
+		{
+			WorkQueue& Own = *Queues[static_cast<size_t>(WorkerIndex)];
+			std::lock_guard<std::mutex> Lock(Own.Mutex);
+			if (!Own.Indices.empty())
+			{
+				OutIndex = Own.Indices.front();
+				Own.Indices.pop_front();
+				return true;
+			}
+		}
+
+		const int32 QueueCount = GetThreadCount();
+		for (int32 Offset = 1; Offset < QueueCount; Offset++)
+		{
+			WorkQueue& Victim = *Queues[static_cast<size_t>((WorkerIndex + Offset) % QueueCount)];
+			std::lock_guard<std::mutex> Lock(Victim.Mutex);
+			if (!Victim.Indices.empty())
+			{
+				OutIndex = Victim.Indices.back();
+				Victim.Indices.pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ReCodeParserDefine.h"
+#include "ReCppCommon.h"
+
+namespace ReParser
+{
+	/**
+	 * Fixed set of worker threads running the indices of a ParallelFor. Every worker owns a queue
+	 * of indices it takes from the front, a worker whose queue is empty steals from the back of
+	 * another one, so a few long tasks do not leave the other workers idle.
+	 */
+	class RECODEPARSER_API WorkStealingPool
+	{
+	public:
+		using TaskFunc = Re::Func<void(int32 Index)>;
+
+		/** ThreadCount workers including the calling thread, 0 uses one per hardware thread. */
+		explicit WorkStealingPool(int32 ThreadCount = 0);
+		~WorkStealingPool();
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		int32 GetThreadCount() const { return static_cast<int32>(Queues.size()); }
+
+		/** Runs Task for every index in [0, Count) and returns once all are done, the calling thread works too. */
+		void ParallelFor(int32 Count, const TaskFunc& Task);
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex Mutex;
+			std::deque<int32> Indices;
+		};
+
+		void WorkerLoop(int32 WorkerIndex);
+		// runs tasks of its own queue then stolen ones until every queue is empty
+		void RunTasks(int32 WorkerIndex);
+		bool PopTask(int32 WorkerIndex, int32& OutIndex);
+
+		Re::Vector<std::unique_ptr<WorkQueue>> Queues;
+		Re::Vector<std::thread> Threads;
+
+		std::mutex Mutex;
+		std::condition_variable WorkReady;
+		std::condition_variable WorkDone;
+		const TaskFunc* CurrentTask = nullptr;
+		// bumped by every ParallelFor so sleeping workers know there is new work
+		uint64 Generation = 0;
+		int32 PendingCount = 0;
+		bool bStopping = false;
+	};
+}
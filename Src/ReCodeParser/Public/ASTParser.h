@@ -2,7 +2,9 @@
 #include "ReClassInfo.h"
 #include "Private/Internal/BaseParser.h"
 
+#ifndef DEBUG_AST_PARSER
 #define DEBUG_AST_PARSER 1
+#endif
 #if DEBUG_AST_PARSER
 #define TRACE_AST_PARSE_F(Fmt, ...) RE_LOG_F(Fmt, __VA_ARGS__)
 #else
@@ -13,6 +15,10 @@ namespace ReParser::AST
 {
     class ASTParser;
     class ASTNode;
+    class GrammarCompiler;
+    class GrammarProgram;
+    class GrammarVM;
+    class PackratMemo;
 
     using ASTNodePtr = Re::SharedPtr<ASTNode>;
     class RECODEPARSER_API ASTNode
@@ -45,13 +51,74 @@ namespace ReParser::AST
         return Re::MakeShared<T>(std::forward<Ts>(args)...);
     }
 
+    enum class EOperatorAssociativity : uint8
+    {
+        Left,
+        Right,
+        NonAssoc,
+    };
+
+    /** A binary operator of a precedence table, a higher precedence binds tighter. */
+    struct BinaryOperator
+    {
+        Re::String Text;
+        int32 Precedence = 0;
+        EOperatorAssociativity Associativity = EOperatorAssociativity::Left;
+    };
+
+    /** Tokens a parser may start with, by atom of a literal or id of a %token terminal. */
+    struct RECODEPARSER_API FirstSet
+    {
+        // both sorted
+        Re::Vector<int32> Atoms;
+        Re::Vector<int32> Terminals;
+        // parsers without a grammar of their own may start with any token
+        bool bAny = false;
+
+        bool Contains(const Token& token) const;
+        /** @return whether the set grew. */
+        bool Merge(const FirstSet& other);
+        bool AddAtom(int32 atom);
+        bool AddTerminal(int32 terminal);
+        bool AddAny();
+    };
+
+    enum class ELeftRecursion : uint8
+    {
+        None,
+        // on a left-recursive cycle, grows its result from a seed, see ASTParser::ParseRule
+        Leader,
+        // on a left-recursive cycle through a leader, its results depend on the seed and are never memoized
+        Involved,
+    };
+
     class RECODEPARSER_API ASTNodeParser
     {
         DECLARE_CLASS(ASTNodeParser)
     public:
         virtual ~ASTNodeParser() = default;
+        /**
+         * Parses from token, the token is already read. On success the cursor is behind the last token the
+         * rule matched, in front of token when it matched nothing. At the end of the input token is the end token.
+         */
         virtual bool Parse(ICodeFile* file, ASTParser& context, const Token& token, ASTNodePtr* outNode) = 0;
+        /** Lowers the rule into bytecode, by default the VM calls Parse. */
+        virtual void Compile(GrammarCompiler& compiler);
         virtual Re::String ToString() const { return RE_FORMAT("*%s*", StaticClass().GetName()); }
+        /** Interns the literals of the rule so matching them compares atoms, called once the grammar is complete. */
+        virtual void ResolveAtoms(AtomTable& atoms) { }
+        /**
+         * Adds the named rules the parser may run before it consumes a token, named rules are not entered.
+         * @return whether the parser may match nothing.
+         */
+        virtual bool CollectLeftRules(Re::Vector<ASTNodeParser*>& outRules) const { return false; }
+        /**
+         * Recomputes First and nullability from the sub parsers, entering the unnamed ones, named ones are read as
+         * they are. @return whether either grew, BNFFile::GenerateASTParser repeats it until nothing does.
+         */
+        virtual bool UpdateFirst();
+        /** Builds the jump tables of the parser and its unnamed sub parsers once First is final. */
+        virtual void BuildDispatch() { }
 
         void SetDefinedName(const Re::String& name)
         {
@@ -72,8 +139,29 @@ namespace ReParser::AST
             return GetClass().GetName();
         }
 
+        /** Set on named rules when the grammar is built, see ResolveLeftRecursion. */
+        ELeftRecursion GetLeftRecursion() const { return LeftRecursion; }
+        void SetLeftRecursion(ELeftRecursion leftRecursion) { LeftRecursion = leftRecursion; }
+        bool IsNullable() const { return bNullable; }
+        void SetNullable(bool bInNullable) { bNullable = bInNullable; }
+        const FirstSet& GetFirst() const { return First; }
+
+    protected:
+        /** @return whether First grew. */
+        bool MergeFirst(const ASTNodeParser& sub) { return First.Merge(sub.First); }
+        bool MarkNullable()
+        {
+            const bool bGrew = !bNullable;
+            bNullable = true;
+            return bGrew;
+        }
+
+        FirstSet First;
+
     private:
         Re::String CustomName;
+        ELeftRecursion LeftRecursion = ELeftRecursion::None;
+        bool bNullable = false;
     };
 
     class RECODEPARSER_API ASTTree
@@ -82,19 +170,37 @@ namespace ReParser::AST
         bool Parse(ASTNodeParser& parser, ICodeFile* file, ASTParser& context, const Token& token);
 
         const ASTNode& GetRoot() const { return *Root; }
+        bool HasRoot() const { return Root != nullptr; }
+        void SetRoot(const Re::SharedPtr<ASTNode>& root) { Root = root; }
         Re::String ToString() const;
 
     private:
         Re::SharedPtr<ASTNode> Root;
     };
 
+    /** Result of a left-recursive rule at a token while it grows. */
+    struct LeftRecursionSeed
+    {
+        const ASTNodeParser* Rule = nullptr;
+        int32 Pos = 0;
+        bool bParsed = false;
+        // token index behind the match
+        int32 EndPos = 0;
+        ASTNodePtr Node;
+    };
+
     class RECODEPARSER_API ASTParser : public BaseParserWithFile
     {
         DECLARE_CLASS(ASTParser)
+        friend class GrammarVM;
     public:
         explicit ASTParser(const Re::SharedPtr<ASTNodeParser>& lexer)
             : Lexer(lexer)
         {
+            // grammar rules backtrack a lot, serve them from a token array instead of re-lexing
+            SetPreTokenize(true);
+            // grammar literals compare atoms instead of text
+            SetAtoms(Re::MakeShared<AtomTable>());
         }
 
         bool CompileDeclaration(ICodeFile* file, const Token& token) override;
@@ -103,9 +209,45 @@ namespace ReParser::AST
 
         const ASTTree& GetASTTree() const { return Tree; }
 
+        /**
+         * Runs the grammar compiled to bytecode instead of walking the parser tree, on by default.
+         * The bytecode needs a pre-tokenized input with atoms, the tree is walked otherwise.
+         */
+        void SetUseBytecode(bool bEnable) { bUseBytecode = bEnable; }
+        const GrammarProgram* GetProgram();
+
+        /**
+         * Remembers the result of every named rule at every token of a declaration, so backtracking runs a rule
+         * at most once per position. Keeps at most maxEntries results, the least recently used go first. The cap
+         * counts results, not bytes, each holds its node alive. 0 turns it off, off by default.
+         */
+        void SetPackratMemoEntries(int32 maxEntries);
+        const PackratMemo* GetPackratMemo() const { return Re::SharedPtrGet(Memo); }
+
+        /**
+         * Parses rule from token like rule.Parse, through the memo for named rules when it is on. A left-recursive
+         * leader is parsed again and again from token, every pass reading the result of the last one where it
+         * calls itself, until the match stops growing. Leaders need a pre-tokenized input, they fail with
+         * ASTLeftRecursionNotPreTokenized otherwise.
+         */
+        bool ParseRule(ASTNodeParser& rule, ICodeFile* file, const Token& token, ASTNodePtr* outNode);
+        /** Named rules entered since the parser was created, memo hits included, a measure of the parsing work. */
+        int64 GetRuleCallNum() const { return RuleCallNum; }
+
     private:
+        bool GrowSeed(ASTNodeParser& rule, ICodeFile* file, const Token& token, int32 pos, ASTNodePtr* outNode);
+        LeftRecursionSeed* FindSeed(const ASTNodeParser& rule, int32 pos);
+        bool IsGrowingAt(int32 pos) const;
+
         ASTTree Tree;
         Re::SharedPtr<ASTNodeParser> Lexer;
+        Re::SharedPtr<GrammarProgram> Program;
+        Re::SharedPtr<GrammarVM> VM;
+        Re::SharedPtr<PackratMemo> Memo;
+        // left-recursive rules growing, innermost last
+        Re::Vector<LeftRecursionSeed> Seeds;
+        bool bUseBytecode = true;
+        int64 RuleCallNum = 0;
         Re::Map<Re::String, Re::SharedPtr<ASTNodeParser>> CustomParsers;
     };
 }
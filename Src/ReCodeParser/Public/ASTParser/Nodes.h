@@ -97,7 +97,7 @@ namespace ReParser::AST
         explicit ConstNode(const Token& token)
                            : ConstToken(token)
         {
-            RE_ASSERT(token.GetTokenType() == ETokenType::Symbol);
+            RE_ASSERT(token.GetTokenType() == ETokenType::Const);
         }
 
         const Token& GetToken() const
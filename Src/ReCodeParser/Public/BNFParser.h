@@ -2,6 +2,8 @@
 #include "ReCodeParserDefine.h"
 #include "ASTParser.h"
 #include "Private/Internal/BaseParser.h"
+#include "Private/Internal/MappedSource.h"
+#include "Private/Internal/WorkStealingPool.h"
 
 namespace ReParser::AST
 {
@@ -34,6 +36,26 @@ namespace ReParser::BNF
  *          A+      //A可出现1次或多次
  *          (A B)   //A和B被组合在一起
  *          A|B     //A、B是并列选项，只能选一个
+ *
+ *   token patterns, compiled into one DFA that the generated ASTParser lexes with
+ *          %token <kind> <Name> "<regex>"    // kind : skip | identifier | symbol | number | string
+ *          %token skip       Blank  "[ \t\r\n]+"
+ *          %token identifier Name   "[A-Za-z_][A-Za-z0-9_]*"
+ *          %token number     Number "[0-9]+(\.[0-9]+)?([eE][-+]?[0-9]+)?"
+ *          <Name>  // matches a token of the pattern, declare tokens before the rules using them
+ *
+ *   reserved words, identifiers lexed by the generated ASTParser carry their keyword id
+ *          %keyword local function end
+ *
+ *   multi-character operators lexed as one symbol by the generated ASTParser, replacing the C-like ones
+ *          %operator ".." "..." "~=" "::"
+ *
+ *   binary operators by precedence, later lines bind tighter, a rule with alternatives like <expr> <op> <expr>
+ *   is parsed by precedence climbing over them, its other alternatives are the operands
+ *          %left "||"
+ *          %left "&&"
+ *          %nonassoc "==" "<" ">"
+ *          %right "^"
 
  **/
 
@@ -45,33 +67,43 @@ namespace ReParser::BNF
         explicit BNFFile(const Re::String& filePath)
             : FilePath(filePath)
         {
-            if(!std::filesystem::exists(filePath))
+            if(!std::filesystem::exists(filePath) || !Content.Open(filePath))
             {
                 RE_ERROR_F("read ini file %s failed !!", filePath.c_str());
-                return;
             }
-            std::ifstream t(filePath);
-            std::stringstream buffer;
-            buffer << t.rdbuf();
-            Content = buffer.str();
         }
 
         explicit BNFFile(const Re::String& filePath, const Re::String& content)
             : FilePath(filePath)
-            , Content(content)
         {
+            Content.Assign(content);
         }
 
         static Re::SharedPtr<BNFFile> Parse(const Re::String& filePath);
         static Re::SharedPtr<BNFFile> Parse(const Re::String& filePath, const Re::String& content);
         static Re::SharedPtr<BNFFile> ParseWithoutFile(const Re::String& content) { return Parse("UNKNOWN", content); }
 
+        /** Parses the files on the pool, one parser per file, the results keep the order of filePaths. */
+        static Re::Vector<FileParseResult<BNFFile>> ParseBatch(const Re::Vector<Re::String>& filePaths, WorkStealingPool& pool);
+
         using RuleLexersMap = Re::Map<Re::String, Re::SharedPtr<AST::ASTNodeParser>>;
+        const Re::Vector<TokenPattern>& GetTokenPatterns() const { return TokenPatterns; }
+        bool AppendTokenPattern(const TokenPattern& pattern);
+        // index of the token pattern, -1 if name is not a token
+        int32 FindTokenPattern(const Re::String& name) const;
+        const Re::Vector<Re::String>& GetKeywords() const { return Keywords; }
+        void AppendKeyword(const Re::String& keyword) { Keywords.push_back(keyword); }
+        const Re::Vector<Re::String>& GetOperators() const { return Operators; }
+        void AppendOperator(const Re::String& op) { Operators.push_back(op); }
+        const Re::Vector<AST::BinaryOperator>& GetBinaryOperators() const { return BinaryOperators; }
+        /** Appends the operators of a %left, %right or %nonassoc line, binding tighter than the ones before. */
+        void AppendPrecedenceLevel(AST::EOperatorAssociativity associativity, const Re::Vector<Re::String>& operators);
+
         const RuleLexersMap& GetRuleLexers() const { return RuleLexers; }
         bool AppendRule(const Re::String& ruleName, Re::SharedPtr<AST::ASTNodeParser>* outParserPtr);
 
         const Re::String& GetFilePath() const override { return FilePath; }
-        const Re::String& GetContent() const override { return Content; }
+        std::string_view GetContent() const override { return Content.GetView(); }
 
         Re::SharedPtr<AST::ASTParser> GenerateASTParser() const;
 
@@ -79,8 +111,13 @@ namespace ReParser::BNF
 
     private:
         Re::String FilePath;
-        Re::String Content;
+        MappedSource Content;
         RuleLexersMap RuleLexers;
+        Re::Vector<TokenPattern> TokenPatterns;
+        Re::Vector<Re::String> Keywords;
+        Re::Vector<Re::String> Operators;
+        Re::Vector<AST::BinaryOperator> BinaryOperators;
+        int32 PrecedenceLevelNum = 0;
     };
 
 }
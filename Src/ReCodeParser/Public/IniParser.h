@@ -3,6 +3,8 @@
 #include "ReCodeParserDefine.h"
 #include "ReClassInfo.h"
 #include "Private/Internal/BaseParser.h"
+#include "Private/Internal/MappedSource.h"
+#include "Private/Internal/WorkStealingPool.h"
 
 namespace ReParser::Ini
 {
@@ -158,20 +160,18 @@ namespace ReParser::Ini
 		explicit IniFile(const Re::String& filePath)
 			: FilePath(filePath)
 		{
-			if(!std::filesystem::exists(filePath))
+			if(!std::filesystem::exists(filePath) || !Content.Open(filePath))
 			{
 				RE_ERROR_F("read ini file %s failed !!", filePath.c_str());
-				return;
 			}
-			std::ifstream t(filePath);
-			std::stringstream buffer;
-			buffer << t.rdbuf();
-			Content = buffer.str();
 		}
 	public:
 
 		 static IniFilePtr Parse(const Re::String& filePath);
 
+		 /** Parses the files on the pool, one parser per file, the results keep the order of filePaths. */
+		 static Re::Vector<FileParseResult<IniFile>> ParseBatch(const Re::Vector<Re::String>& filePaths, WorkStealingPool& pool);
+
 		 void OnNextToken(BaseParser& parser, const Token& token) override { }
 
 		 IniSection* operator[] (const Re::String& sectionName) const
@@ -195,7 +195,7 @@ namespace ReParser::Ini
 		 }
 
 		const Re::String& GetFilePath() const override { return FilePath; }
-		const Re::String& GetContent() const override { return Content; }
+		std::string_view GetContent() const override { return Content.GetView(); }
 
 		const Re::Map<Re::String, Re::SharedPtr<IniSection>>& GetSections() const
 		{
@@ -206,7 +206,7 @@ namespace ReParser::Ini
 
 	private:
 		Re::String FilePath;
-		Re::String Content;
+		MappedSource Content;
 		Re::Map<Re::String, Re::SharedPtr<IniSection>> Sections;
 	};
 
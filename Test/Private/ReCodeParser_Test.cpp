@@ -6,5 +6,24 @@ int main()
 	// TestIni();
 	// TestBNF();
 	TestASTParser();
+	TestTokenPatterns();
+	// BenchmarkLexer();
+	TestIncrementalLex();
+	TestSourceSpan();
+	TestStreamLex();
+	TestUtf8Lex();
+	TestCommentCapture();
+	TestDiagnostics();
+	TestBatchParse();
+	// BenchmarkBatchParse();
+	TestGrammarBytecode();
+	// BenchmarkGrammarBytecode();
+	TestPackratMemo();
+	// BenchmarkPackratMemo();
+	TestLeftRecursion();
+	TestPrecedenceClimbing();
+	// BenchmarkPrecedenceClimbing();
+	TestFirstSets();
+	// BenchmarkFirstSets();
 	return 0;
 }
@@ -1,10 +1,18 @@
 #include "TestCases.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <thread>
 
 #include "IniParser.h"
 #include "BNFParser.h"
+#include "Private/ASTParser/GrammarProgram.h"
 #include "ASTParser/Nodes.h"
+#include "Private/ASTParser/PackratMemo.h"
+#include "Private/Internal/NumberScan.h"
 
 void TestIni()
 {
@@ -55,4 +63,858 @@ void TestASTParser()
 	auto astTree = parser->GetASTTree();
 
 	RE_LOG(astTree.ToString());
-}
\ No newline at end of file
+}
+
+void TestTokenPatterns()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestTokens.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+	RE_LOG(bnfFile->ToString())
+
+	auto parser = bnfFile->GenerateASTParser();
+	RE_ASSERT(parser);
+	parser->InitParserSource("local t = { 0x1F, 2.5e3, 'a\\'b' } -- comment\nprint(t[1] .. \"x\", ...) ~= nil");
+	while (auto token = parser->GetToken())
+	{
+		RE_LOG_F("%d : %d : %d : %d : %s", token->GetTerminalId(), token->GetKeywordId(), token->GetSymbolId(), token->GetAtomId(), token->GetTokenName().c_str());
+	}
+
+	ReParser::BaseParser luaLexer;
+	luaLexer.SetOperators(Re::MakeShared<ReParser::OperatorTable>(bnfFile->GetOperators()));
+	luaLexer.InitParserSource("a = b..c ... ~= d :: e >> f");
+	while (auto token = luaLexer.GetToken())
+	{
+		RE_LOG_F("%d : %s", token->GetSymbolId(), token->GetTokenName().c_str());
+	}
+}
+
+namespace
+{
+	class LexerBenchmarkParser : public ReParser::BaseParser
+	{
+	public:
+		explicit LexerBenchmarkParser(bool bInIniComments)
+			: bIniComments(bInIniComments)
+		{
+		}
+
+		bool CompileDeclaration(const ReParser::Token& token) override
+		{
+			TokenCount++;
+			return true;
+		}
+
+		int64 TokenCount = 0;
+
+	protected:
+		bool IsBeginComment(char currentChar) override { return !bIniComments && BaseParser::IsBeginComment(currentChar); }
+		bool IsEndComment(char currentChar) override { return !bIniComments && BaseParser::IsEndComment(currentChar); }
+		bool IsLineComment(char currentChar) override { return bIniComments ? currentChar == '#' || currentChar == ';' : BaseParser::IsLineComment(currentChar); }
+
+	private:
+		bool bIniComments = false;
+	};
+
+	struct IniBenchmarkLexPolicy : ReParser::DefaultLexPolicy
+	{
+		static constexpr bool IsBeginComment(char c, char Next) { return false; }
+		static constexpr bool IsEndComment(char c, char Next) { return false; }
+		static constexpr bool IsLineComment(char c, char Next) { return c == '#' || c == ';'; }
+	};
+
+	// same counting parser with the lexing rules fixed at compile time
+	template <typename LexPolicy>
+	class PolicyBenchmarkParser : public ReParser::TBaseParser<LexPolicy>
+	{
+	public:
+		bool CompileDeclaration(const ReParser::Token& token) override
+		{
+			TokenCount++;
+			return true;
+		}
+
+		int64 TokenCount = 0;
+	};
+
+	Re::String MakeIniBenchmarkInput(int32 sectionCount)
+	{
+		Re::String result;
+		for (int32 i = 0; i < sectionCount; i++)
+		{
+			result += "; section " + std::to_string(i) + "\n";
+			result += "[Section" + std::to_string(i) + "]\n";
+			result += "Name=\"Item " + std::to_string(i) + "\"\n";
+			result += "+PropList=Value" + std::to_string(i) + "\n";
+			result += "List=[" + std::to_string(i) + ", " + std::to_string(i * 2) + ", 3.5, 0x1F]\n";
+			result += "Map=(a=1, b=true, c=Identifier_" + std::to_string(i) + ")\n\n";
+		}
+		return result;
+	}
+
+	// the ini input with CJK section names, keys and values
+	Re::String MakeCJKIniBenchmarkInput(int32 sectionCount)
+	{
+		Re::String result;
+		for (int32 i = 0; i < sectionCount; i++)
+		{
+			result += "; \xE8\xA8\xAD\xE5\xAE\x9A " + std::to_string(i) + "\n";
+			result += "[\xE8\xA8\xAD\xE5\xAE\x9A" + std::to_string(i) + "]\n";
+			result += "\xE5\x90\x8D\xE5\x89\x8D=\"\xE9\xA0\x85\xE7\x9B\xAE " + std::to_string(i) + "\"\n";
+			result += "+\xE4\xB8\x80\xE8\xA6\xA7=\xE5\x80\xA4" + std::to_string(i) + "\n";
+			result += "List=[" + std::to_string(i) + ", " + std::to_string(i * 2) + ", 3.5, 0x1F]\n";
+			result += "Map=(a=1, b=true, c=\xE8\xAD\x98\xE5\x88\xA5\xE5\xAD\x90_" + std::to_string(i) + ")\n\n";
+		}
+		return result;
+	}
+
+	// the ini input with a block of comment lines over every section
+	Re::String MakeCommentedIniBenchmarkInput(int32 sectionCount)
+	{
+		Re::String comments;
+		for (int32 i = 0; i < 8; i++)
+		{
+			comments += "; documentation line " + std::to_string(i) + " of the section below, as verbose config files have\n";
+		}
+		Re::String result;
+		for (int32 i = 0; i < sectionCount; i++)
+		{
+			result += comments;
+			result += "[Section" + std::to_string(i) + "]\n";
+			result += "Name=\"Item " + std::to_string(i) + "\"\n\n";
+		}
+		return result;
+	}
+
+	Re::String MakeNumberListBenchmarkInput(int32 lineCount)
+	{
+		Re::String result;
+		for (int32 i = 0; i < lineCount; i++)
+		{
+			result += "List" + std::to_string(i) + "=[";
+			for (int32 j = 0; j < 64; j++)
+			{
+				result += std::to_string(i * 64 + j) + (j % 4 == 3 ? ".25e2" : "") + ",";
+			}
+			result += "-1]\n";
+		}
+		return result;
+	}
+
+	Re::String MakeBNFBenchmarkInput(int32 ruleCount)
+	{
+		Re::String result;
+		for (int32 i = 0; i < ruleCount; i++)
+		{
+			result += "// rule " + std::to_string(i) + "\n";
+			result += "<rule" + std::to_string(i) + ">\t::=\t\"{\" <name> \"}\" | <expr> \">=\" <expr> | [ \"(\" <rule" + std::to_string(i + 1) + "> \")\" ]+\n";
+		}
+		return result;
+	}
+
+	template <typename ParserType>
+	void RunLexerBenchmark(const char* name, const Re::String& input, ParserType& parser)
+	{
+		constexpr int32 Iterations = 5;
+		auto start = std::chrono::steady_clock::now();
+		for (int32 i = 0; i < Iterations; i++)
+		{
+			parser.InitParserSource(input.c_str());
+			parser.ParseWithoutFile();
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		double megaBytes = static_cast<double>(input.size()) * Iterations / (1024.0 * 1024.0);
+		RE_LOG_F("lex %s : %.2f MB in %.3f s, %.2f MB/s, %lld tokens", name, megaBytes, elapsed.count(),
+			megaBytes / elapsed.count(), static_cast<long long>(parser.TokenCount / Iterations));
+	}
+}
+
+void BenchmarkLexer()
+{
+	const Re::String iniInput = MakeIniBenchmarkInput(50000);
+	const Re::String bnfInput = MakeBNFBenchmarkInput(50000);
+
+	LexerBenchmarkParser iniParser(true);
+	LexerBenchmarkParser bnfParser(false);
+	RunLexerBenchmark("ini", iniInput, iniParser);
+	RunLexerBenchmark("bnf", bnfInput, bnfParser);
+
+	PolicyBenchmarkParser<IniBenchmarkLexPolicy> iniPolicyParser;
+	PolicyBenchmarkParser<ReParser::DefaultLexPolicy> bnfPolicyParser;
+	RunLexerBenchmark("ini policy", iniInput, iniPolicyParser);
+	LexerBenchmarkParser cjkIniParser(true);
+	RunLexerBenchmark("ini cjk", MakeCJKIniBenchmarkInput(50000), cjkIniParser);
+	RunLexerBenchmark("bnf policy", bnfInput, bnfPolicyParser);
+
+	const Re::String commentedInput = MakeCommentedIniBenchmarkInput(20000);
+	LexerBenchmarkParser commentedParser(true);
+	RunLexerBenchmark("ini commented", commentedInput, commentedParser);
+	LexerBenchmarkParser uncapturedParser(true);
+	uncapturedParser.SetCaptureComments(false);
+	RunLexerBenchmark("ini commented, no capture", commentedInput, uncapturedParser);
+
+	PolicyBenchmarkParser<IniBenchmarkLexPolicy> numberParser;
+	RunLexerBenchmark("number list", MakeNumberListBenchmarkInput(20000), numberParser);
+}
+namespace
+{
+	// whether two parsers hand out the same token stream
+	bool HasSameTokens(ReParser::BaseParser& lhs, ReParser::BaseParser& rhs)
+	{
+		for (;;)
+		{
+			auto lhsToken = lhs.GetToken();
+			auto rhsToken = rhs.GetToken();
+			if (!lhsToken || !rhsToken)
+			{
+				return !lhsToken && !rhsToken;
+			}
+			if (!(*lhsToken == *rhsToken) || lhs.GetLine(lhsToken->GetStartPos()) != rhs.GetLine(rhsToken->GetStartPos())
+				|| lhsToken->GetTokenView() != rhsToken->GetTokenView())
+			{
+				return false;
+			}
+		}
+	}
+}
+
+void TestIncrementalLex()
+{
+	const Re::String input = MakeBNFBenchmarkInput(20000);
+	LexerBenchmarkParser parser(false);
+	parser.SetPreTokenize(true);
+	parser.InitParserSource(input.c_str());
+
+	struct Edit
+	{
+		int32 offset;
+		int32 removedLength;
+		const char* insertedText;
+	};
+	const int32 middle = static_cast<int32>(input.size()) / 2;
+	const Edit edits[] = {
+		{ 0, 0, "<start> ::= \"a\"\n" },
+		{ 120, 3, "" },
+		{ middle, 1, "\n>>= 12.5e3 'x'" },
+		{ middle + 40, 0, "/* comment " },
+		{ middle + 400, 0, " */" },
+		{ middle + 2, 6, "x" },
+		{ middle + 3, 0, "y" },
+		{ middle + 4, 0, "z" },
+	};
+	for (const Edit& edit : edits)
+	{
+		ReParser::TokenEditRange range;
+		auto start = std::chrono::steady_clock::now();
+		RE_ASSERT(parser.ApplyEdit(edit.offset, edit.removedLength, edit.insertedText, range));
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		LexerBenchmarkParser fresh(false);
+		fresh.SetPreTokenize(true);
+		start = std::chrono::steady_clock::now();
+		fresh.InitParserSource(parser.GetSource().data());
+		std::chrono::duration<double, std::milli> freshElapsed = std::chrono::steady_clock::now() - start;
+		RE_ASSERT(HasSameTokens(parser, fresh));
+
+		RE_LOG_F("edit at %d : tokens [%d, %d) -> %d tokens, %.3f ms, full re-lex %.3f ms", edit.offset, range.First,
+			range.First + range.OldNum, range.NewNum, elapsed.count(), freshElapsed.count());
+	}
+}
+
+void TestSourceSpan()
+{
+	// the span stops inside a string constant, lexing must end at its length and not at the NUL of the buffer
+	const Re::String buffer = MakeBNFBenchmarkInput(100) + "\"cut here\" <tail>";
+	const int64 length = static_cast<int64>(buffer.size()) - 12;
+	LexerBenchmarkParser span(false);
+	span.InitParserSource("span", buffer.data(), length);
+
+	const Re::String copy = buffer.substr(0, static_cast<size_t>(length));
+	LexerBenchmarkParser terminated(false);
+	terminated.InitParserSource(copy.c_str());
+	RE_ASSERT(HasSameTokens(span, terminated));
+	RE_LOG_F("span of %lld chars lexed up to %s", static_cast<long long>(length), span.GetLocation().c_str());
+}
+
+namespace
+{
+	// records every token with its line, tokens are recycled after each one like a parser does
+	class TokenRecordParser : public LexerBenchmarkParser
+	{
+	public:
+		using LexerBenchmarkParser::LexerBenchmarkParser;
+
+		bool CompileDeclaration(const ReParser::Token& token) override
+		{
+			Records.push_back(token.GetTokenName() + "@" + std::to_string(GetLine(token.GetStartPos())));
+			return true;
+		}
+
+		Re::Vector<Re::String> Records;
+	};
+}
+
+void TestStreamLex()
+{
+	const Re::String input = MakeIniBenchmarkInput(20000) + "; trailing comment";
+	size_t readPos = 0;
+	TokenRecordParser streamed(true);
+	streamed.InitParserStream("stream", [&](char* buffer, int64 capacity) -> int64
+	{
+		// odd sized reads so tokens straddle the chunks
+		const size_t count = std::min({ static_cast<size_t>(capacity), size_t{ 37 }, input.size() - readPos });
+		std::memcpy(buffer, input.data() + readPos, count);
+		readPos += count;
+		return static_cast<int64>(count);
+	}, 256);
+	streamed.ParseWithoutFile();
+
+	TokenRecordParser whole(true);
+	whole.InitParserSource(input.c_str());
+	whole.ParseWithoutFile();
+	RE_ASSERT(streamed.Records == whole.Records);
+	RE_LOG_F("streamed %d tokens of %lld chars, %s", static_cast<int32>(streamed.Records.size()),
+		static_cast<long long>(input.size()), streamed.GetLocation().c_str());
+}
+
+void TestUtf8Lex()
+{
+	// a CJK key, a CJK string value and escapes decoded to UTF-8
+	const char* input = "\xE5\x90\x8D\xE5\x89\x8D_1=\"\xE9\xA0\x85\xE7\x9B\xAE \\u4E2D \\U0001F600 \\x41\" '\xE4\xB8\xAD' '\\u00e9'";
+	TokenRecordParser parser(true);
+	parser.InitParserSource(input);
+	parser.ParseWithoutFile();
+	const Re::Vector<Re::String> expected = {
+		"\xE5\x90\x8D\xE5\x89\x8D_1@1", "=@1", "\xE9\xA0\x85\xE7\x9B\xAE \xE4\xB8\xAD \xF0\x9F\x98\x80 A@1", "\xE4\xB8\xAD@1", "\xC3\xA9@1" };
+	Re::String error;
+	RE_ASSERT(parser.Records == expected && !parser.GetError(error));
+
+	// a stray continuation byte, a surrogate and a truncated escape are reported
+	for (const char* invalid : { "key\x80=1", "\"\xED\xA0\x80\"", "'\\uD800'", "\"\\u12\"" })
+	{
+		TokenRecordParser invalidParser(true);
+		invalidParser.InitParserSource(invalid);
+		invalidParser.ParseWithoutFile();
+		RE_ASSERT(invalidParser.GetError(error));
+	}
+	RE_LOG_F("utf-8 lexed %d tokens, %s", static_cast<int32>(parser.Records.size()), parser.GetLocation().c_str());
+}
+
+void TestCommentCapture()
+{
+	const char* input =
+		"// detached by the blank line\n"
+		"\n"
+		"/* the key */\n"
+		"// more about it\n"
+		"Key = 1 // after the value\n"
+		"Other = 2\n";
+	LexerBenchmarkParser parser(false);
+	parser.InitParserSource(input);
+	const ReParser::Token* key = parser.GetToken();
+	RE_ASSERT(parser.GetDocComment(*key) == "/* the key */\n// more about it");
+	const ReParser::Token* equal = parser.GetToken();
+	RE_ASSERT(parser.GetDocComment(*equal).empty());
+	parser.GetToken();
+	const ReParser::Token* other = parser.GetToken();
+	RE_ASSERT(parser.GetDocComment(*other) == "// after the value");
+	RE_ASSERT(parser.GetComments().size() == 4);
+
+	LexerBenchmarkParser uncaptured(false);
+	uncaptured.SetCaptureComments(false);
+	uncaptured.InitParserSource(input);
+	uncaptured.ParseWithoutFile();
+	RE_ASSERT(uncaptured.GetComments().empty());
+	RE_LOG_F("%d comments captured", static_cast<int32>(parser.GetComments().size()));
+}
+
+void TestDiagnostics()
+{
+	// one invalid escape per line, the lexer keeps going after each
+	Re::String input;
+	for (int32 i = 0; i < 100; i++)
+	{
+		input += "\"\\u12\"\n";
+	}
+	LexerBenchmarkParser parser(false);
+	parser.GetDiagnostics().SetErrorLimit(10);
+	parser.InitParserSource("diagnostics", input.c_str());
+	int32 tokenCount = 0;
+	while (parser.GetToken())
+	{
+		tokenCount++;
+	}
+	const ReParser::DiagnosticEngine& diagnostics = parser.GetDiagnostics();
+	RE_ASSERT(tokenCount == 100 && diagnostics.GetErrorCount() == 100 && diagnostics.GetDiagnostics().size() == 10);
+	RE_ASSERT(diagnostics.GetDiagnostics()[3].Code == ReParser::EDiagnosticCode::InvalidEscape);
+
+	Re::String error;
+	RE_ASSERT(parser.GetError(error));
+	RE_ASSERT(diagnostics.GetDiagnostics()[3].Location.Line == 4);
+	RE_ASSERT(error.find("Invalid escape sequence: \\u12 : at diagnostics : 4:") != Re::String::npos);
+	RE_ASSERT(error.find("90 more diagnostics not kept") != Re::String::npos);
+
+	// the first error stops the lexing
+	LexerBenchmarkParser stopped(false);
+	stopped.GetDiagnostics().SetAbortPolicy(ReParser::EDiagnosticAbortPolicy::FirstError);
+	stopped.InitParserSource(input.c_str());
+	tokenCount = 0;
+	while (stopped.GetToken())
+	{
+		tokenCount++;
+	}
+	RE_ASSERT(tokenCount == 1 && stopped.GetDiagnostics().GetErrorCount() == 1);
+
+	// out of range constants saturate, hex ones to the widest bit pattern
+	struct
+	{
+		const char* Text;
+		const char* Value;
+		bool bInRange;
+	} numbers[] = {
+		{ "99999999999999999999", "9223372036854775807", false },
+		{ "-99999999999999999999", "-9223372036854775808", false },
+		{ "0x10000000000000000", "-1", false },
+		{ "-0x8000000000000000", "-9223372036854775808", true },
+	};
+	for (auto& number : numbers)
+	{
+		ReParser::Token token;
+		int64 length = 0;
+		const ReParser::ENumberScanResult result = ReParser::ScanNumber(number.Text, number.Text + strlen(number.Text), token, length);
+		RE_ASSERT(length == static_cast<int64>(strlen(number.Text)) && token.GetConstantValue() == number.Value);
+		RE_ASSERT((result == ReParser::ENumberScanResult::Ok) == number.bInRange);
+	}
+	RE_LOG_F("%d diagnostics, %d kept", diagnostics.GetErrorCount(), static_cast<int32>(diagnostics.GetDiagnostics().size()));
+}
+
+namespace
+{
+	// writes the contents as numbered files of a fresh temporary directory
+	Re::Vector<Re::String> WriteBatchFiles(const char* dirName, const char* extension, const Re::Vector<Re::String>& contents)
+	{
+		const auto dir = std::filesystem::temp_directory_path() / dirName;
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		Re::Vector<Re::String> paths;
+		for (size_t i = 0; i < contents.size(); i++)
+		{
+			const auto path = dir / (std::to_string(i) + extension);
+			std::ofstream(path, std::ios::binary) << contents[i];
+			paths.push_back(path.string());
+		}
+		return paths;
+	}
+}
+
+void TestBatchParse()
+{
+	Re::Vector<Re::String> contents;
+	for (int32 i = 0; i < 32; i++)
+	{
+		contents.push_back(i == 7 ? Re::String("[Broken\n") : MakeIniBenchmarkInput(i + 1));
+	}
+	Re::Vector<Re::String> paths = WriteBatchFiles("ReCodeParserBatchTest", ".ini", contents);
+	paths.push_back(paths.back() + ".missing");
+
+	ReParser::WorkStealingPool pool(4);
+	const auto results = ReParser::Ini::IniFile::ParseBatch(paths, pool);
+	RE_ASSERT(results.size() == paths.size());
+	for (size_t i = 0; i < contents.size(); i++)
+	{
+		const auto expected = ReParser::Ini::IniFile::Parse(paths[i]);
+		RE_ASSERT(results[i].File && results[i].File->ToString() == expected->ToString());
+		RE_ASSERT(results[i].Error.empty() == (i != 7));
+	}
+	RE_ASSERT(!results.back().File && !results.back().Error.empty());
+
+	auto bnfPath = std::filesystem::path{__FILE__}.parent_path() / "TestTokens.bnf";
+	const auto bnfResults = ReParser::BNF::BNFFile::ParseBatch({ bnfPath.string(), bnfPath.string() }, pool);
+	RE_ASSERT(bnfResults[0].File && bnfResults[0].File->ToString() == bnfResults[1].File->ToString());
+	RE_LOG_F("batch parsed %d files, %s", static_cast<int32>(results.size()), results[7].Error.c_str());
+}
+
+void BenchmarkBatchParse()
+{
+	Re::Vector<Re::String> contents;
+	for (int32 i = 0; i < 256; i++)
+	{
+		contents.push_back(MakeIniBenchmarkInput(400 + i % 16 * 50));
+	}
+	const Re::Vector<Re::String> paths = WriteBatchFiles("ReCodeParserBatchBenchmark", ".ini", contents);
+
+	const int32 maxThreads = std::max(1, static_cast<int32>(std::thread::hardware_concurrency()));
+	double singleSeconds = 0.0;
+	for (int32 threads = 1; ; threads = std::min(threads * 2, maxThreads))
+	{
+		ReParser::WorkStealingPool pool(threads);
+		auto start = std::chrono::steady_clock::now();
+		const auto results = ReParser::Ini::IniFile::ParseBatch(paths, pool);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (threads == 1)
+		{
+			singleSeconds = elapsed.count();
+		}
+		RE_ASSERT(results.size() == paths.size() && results.back().File);
+		RE_LOG_F("batch %d files on %d threads : %.3f s, x%.2f", static_cast<int32>(paths.size()), threads,
+			elapsed.count(), singleSeconds / elapsed.count());
+		if (threads == maxThreads)
+		{
+			break;
+		}
+	}
+}
+
+namespace
+{
+	Re::SharedPtr<ReParser::AST::ASTParser> CreateGrammarParser(const ReParser::BNF::BNFFile& bnfFile, bool bUseBytecode, int32 memoEntries)
+	{
+		auto parser = bnfFile.GenerateASTParser();
+		RE_ASSERT(parser);
+		parser->SetUseBytecode(bUseBytecode);
+		parser->SetPackratMemoEntries(memoEntries);
+		return parser;
+	}
+
+	Re::SharedPtr<ReParser::AST::ASTParser> ParseWithGrammar(const ReParser::BNF::BNFFile& bnfFile, const Re::String& source, bool bUseBytecode, int32 memoEntries = 0)
+	{
+		auto parser = CreateGrammarParser(bnfFile, bUseBytecode, memoEntries);
+		parser->InitParserSource(source.c_str());
+		parser->ParseWithoutFile();
+		return parser;
+	}
+
+	// seconds ParseWithGrammar takes once the parser is generated, the source has to parse
+	double TimeParseWithGrammar(const ReParser::BNF::BNFFile& bnfFile, const Re::String& source, bool bUseBytecode, int32 memoEntries = 0)
+	{
+		auto parser = CreateGrammarParser(bnfFile, bUseBytecode, memoEntries);
+		auto start = std::chrono::steady_clock::now();
+		parser->InitParserSource(source.c_str());
+		parser->ParseWithoutFile();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		RE_ASSERT(parser->GetASTTree().HasRoot());
+		return elapsed.count();
+	}
+
+	// the first node under node, node included, not holding exactly one child
+	const ReParser::AST::ASTNode& SkipSingleChildren(const ReParser::AST::ASTNode& node, Re::Vector<ReParser::AST::ASTNodePtr>& outChildren)
+	{
+		outChildren.clear();
+		node.GetChildNodes(outChildren);
+		if (outChildren.size() == 1)
+		{
+			const ReParser::AST::ASTNodePtr child = outChildren[0];
+			return SkipSingleChildren(*child, outChildren);
+		}
+		return node;
+	}
+
+	// the tree on one line, [] around nodes with several children unless all of them are leaves like { a }
+	Re::String ToGroupingString(const ReParser::AST::ASTNode& node)
+	{
+		Re::Vector<ReParser::AST::ASTNodePtr> children;
+		const ReParser::AST::ASTNode& shown = SkipSingleChildren(node, children);
+		if (children.empty())
+		{
+			return shown.ToString();
+		}
+		Re::String text;
+		bool bLeaves = true;
+		for (auto& child : children)
+		{
+			Re::Vector<ReParser::AST::ASTNodePtr> grandChildren;
+			SkipSingleChildren(*child, grandChildren);
+			bLeaves &= grandChildren.empty();
+			text += (text.empty() ? "" : " ") + ToGroupingString(*child);
+		}
+		if (bLeaves)
+		{
+			text.erase(std::remove(text.begin(), text.end(), ' '), text.end());
+			return text;
+		}
+		return "[" + text + "]";
+	}
+
+	// every level tries <term> of TestPackrat.bnf once per <sum> alternative, 3^depth parses without the memo
+	Re::String MakePackratSource(int32 depth)
+	{
+		return Re::String(static_cast<size_t>(depth), '(') + "a + b" + Re::String(static_cast<size_t>(depth), ')');
+	}
+
+	// terms operands of Test.bnf joined by && and <
+	Re::String MakeOperatorChainSource(int32 terms)
+	{
+		Re::String source = "{a0}";
+		for (int32 i = 1; i < terms; i++)
+		{
+			source += RE_FORMAT(" %s {a%d}", i % 2 ? "&&" : "<", i);
+		}
+		return source;
+	}
+}
+
+void TestGrammarBytecode()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestGrammar.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	auto parser = bnfFile->GenerateASTParser();
+	RE_LOG(parser->GetProgram()->ToString());
+
+	const char* sources[] = {
+		"let a = b; print(a, {b c}, d) let x = {{y} z}",
+		"print(a)",
+		"let a = ;",
+		"print(a, b",
+		"{a}",
+		"",
+	};
+	for (const char* source : sources)
+	{
+		const Re::String bytecode = ParseWithGrammar(*bnfFile, source, true)->GetASTTree().ToString();
+		const Re::String tree = ParseWithGrammar(*bnfFile, source, false)->GetASTTree().ToString();
+		RE_ASSERT(bytecode == tree);
+		RE_LOG_F("%s\n%s", source, bytecode.c_str());
+	}
+}
+
+void BenchmarkGrammarBytecode()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestGrammar.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	Re::String longSource;
+	for (int32 i = 0; i < 20000; i++)
+	{
+		longSource += RE_FORMAT("let v%d = {a {b c} d}; print(v%d, {e}, f) ", i, i);
+	}
+	RE_LOG_F("bytecode %.3f s, tree %.3f s", TimeParseWithGrammar(*bnfFile, longSource, true), TimeParseWithGrammar(*bnfFile, longSource, false));
+}
+
+void TestPackratMemo()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestPackrat.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	const Re::String source = MakePackratSource(6);
+	const Re::String expected = ParseWithGrammar(*bnfFile, source, false)->GetASTTree().ToString();
+	for (bool bUseBytecode : { true, false })
+	{
+		// the misses of a memo are the rules it parses, a small one keeps the entries the choice points come back to
+		int32 missNum[2] = {};
+		for (int32 memoEntries : { 0, 4, 1 << 16 })
+		{
+			auto parser = ParseWithGrammar(*bnfFile, source, bUseBytecode, memoEntries);
+			RE_ASSERT(parser->GetASTTree().HasRoot() && parser->GetASTTree().ToString() == expected);
+			if (auto memo = parser->GetPackratMemo())
+			{
+				RE_LOG_F("%s memo of %d : %d hits, %d misses, %d evicted", bUseBytecode ? "bytecode" : "tree",
+					memoEntries, memo->GetHitNum(), memo->GetMissNum(), memo->GetEvictedNum());
+				missNum[memoEntries == 4 ? 0 : 1] = memo->GetMissNum();
+			}
+		}
+		RE_ASSERT(missNum[0] == missNum[1]);
+	}
+	RE_LOG(expected);
+}
+
+void BenchmarkPackratMemo()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestPackrat.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	for (int32 depth : { 8, 10, 12 })
+	{
+		const Re::String source = MakePackratSource(depth);
+		RE_LOG_F("depth %d : %.4f s without memo, %.4f s with memo", depth,
+			TimeParseWithGrammar(*bnfFile, source, true), TimeParseWithGrammar(*bnfFile, source, true, 1 << 16));
+	}
+}
+
+void TestLeftRecursion()
+{
+	static const char* LeftRecursionNames[] = { "none", "leader", "involved" };
+
+	const char* grammars[][2] = {
+		{ "Test.bnf", "{a} > {b} && ({c} == {d}) || {e}" },
+		{ "TestLeftRecursion.bnf", "a + b * f(c)(d + e) * (g + h)()" },
+	};
+	Re::SharedPtr<ReParser::BNF::BNFFile> bnfFile;
+	for (auto& grammar : grammars)
+	{
+		auto path = std::filesystem::path{__FILE__}.parent_path() / grammar[0];
+		bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+		RE_ASSERT(bnfFile);
+		for (auto& rule : bnfFile->GetRuleLexers())
+		{
+			RE_LOG_F("%s : %s", rule.first.c_str(), LeftRecursionNames[static_cast<int32>(rule.second->GetLeftRecursion())]);
+		}
+
+		// the tokens of a parser point into its source
+		const Re::String source = grammar[1];
+		auto expectedParser = ParseWithGrammar(*bnfFile, source, false);
+		RE_ASSERT(expectedParser->GetASTTree().HasRoot());
+		const Re::String expected = expectedParser->GetASTTree().ToString();
+		for (bool bUseBytecode : { true, false })
+		{
+			for (int32 memoEntries : { 0, 1 << 16 })
+			{
+				RE_ASSERT(ParseWithGrammar(*bnfFile, source, bUseBytecode, memoEntries)->GetASTTree().ToString() == expected);
+			}
+		}
+		RE_LOG_F("%s\n%s", source.c_str(), expected.c_str());
+
+		// without pre-tokens the seeds cannot be kept, the leader fails instead of recursing forever
+		auto lexed = CreateGrammarParser(*bnfFile, false, 0);
+		lexed->SetPreTokenize(false);
+		lexed->InitParserSource(source.c_str());
+		lexed->ParseWithoutFile();
+		RE_ASSERT(!lexed->GetASTTree().HasRoot());
+		RE_ASSERT(lexed->GetDiagnostics().GetDiagnostics()[0].Code == ReParser::EDiagnosticCode::ASTLeftRecursionNotPreTokenized);
+	}
+
+	// the seed of every operand grows once, twice the terms takes twice the time
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "Test.bnf";
+	bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	for (int32 terms : { 200, 400, 800 })
+	{
+		const Re::String source = MakeOperatorChainSource(terms);
+		RE_LOG_F("%d terms : %.4f s without memo, %.4f s with memo", terms,
+			TimeParseWithGrammar(*bnfFile, source, true), TimeParseWithGrammar(*bnfFile, source, true, 1 << 16));
+	}
+}
+
+void TestPrecedenceClimbing()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestPrecedence.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+	RE_LOG(bnfFile->ToString());
+
+	// [] around every node with several children, the braces of an operand stay together
+	struct
+	{
+		const char* Source;
+		const char* Expected;
+	} expressions[] = {
+		// || binds loosest and is left associative, == binds tightest
+		{ "{a} || {b} && {c} == {d} || {e}", "[[{a} || [{b} && [{c} == {d}]]] || {e}]" },
+		{ "({a} || {b}) && {c}", "[[( [{a} || {b}] )] && {c}]" },
+		{ "{a} < {b} && {c} || {d}", "[[[{a} < {b}] && {c}] || {d}]" },
+		// == is non-associative, a chain of them is an error
+		{ "{a} == {b} == {c}", nullptr },
+		{ "{a} == {b} < {c}", nullptr },
+	};
+	for (auto& expression : expressions)
+	{
+		// by value, the tokens of a parser point into its source
+		const Re::String source = expression.Source;
+		auto parser = ParseWithGrammar(*bnfFile, source, false);
+		if (!expression.Expected)
+		{
+			RE_ASSERT(!parser->GetASTTree().HasRoot());
+			RE_ASSERT(parser->GetDiagnostics().GetDiagnostics()[0].Code == ReParser::EDiagnosticCode::ASTNonAssocChain);
+			continue;
+		}
+		RE_ASSERT(parser->GetASTTree().HasRoot());
+		const Re::String grouping = ToGroupingString(parser->GetASTTree().GetRoot());
+		RE_LOG_F("%s\n%s", source.c_str(), grouping.c_str());
+		RE_ASSERT(grouping == expression.Expected);
+	}
+
+	// one pass over the tokens enters fewer rules than the seed growing of the same grammar without the table,
+	// both by the tree walker the climbing always runs in
+	auto seedPath = std::filesystem::path{__FILE__}.parent_path() / "Test.bnf";
+	auto seedFile = ReParser::BNF::BNFFile::Parse(seedPath.string());
+	RE_ASSERT(seedFile);
+	for (int32 terms : { 10, 100 })
+	{
+		const Re::String source = MakeOperatorChainSource(terms);
+		auto climbing = ParseWithGrammar(*bnfFile, source, false);
+		auto seedGrowing = ParseWithGrammar(*seedFile, source, false);
+		RE_ASSERT(climbing->GetASTTree().HasRoot() && seedGrowing->GetASTTree().HasRoot());
+		RE_LOG_F("%d terms : %lld rules climbing, %lld rules seed growing", terms,
+			static_cast<long long>(climbing->GetRuleCallNum()), static_cast<long long>(seedGrowing->GetRuleCallNum()));
+		RE_ASSERT(climbing->GetRuleCallNum() < seedGrowing->GetRuleCallNum());
+	}
+}
+
+void BenchmarkPrecedenceClimbing()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestPrecedence.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+	auto seedPath = std::filesystem::path{__FILE__}.parent_path() / "Test.bnf";
+	auto seedFile = ReParser::BNF::BNFFile::Parse(seedPath.string());
+	RE_ASSERT(seedFile);
+
+	for (int32 terms : { 200, 400, 800 })
+	{
+		const Re::String source = MakeOperatorChainSource(terms);
+		RE_LOG_F("%d terms : %.4f s climbing, %.4f s seed growing", terms,
+			TimeParseWithGrammar(*bnfFile, source, false), TimeParseWithGrammar(*seedFile, source, false));
+	}
+}
+
+void TestFirstSets()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestFirst.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	auto parser = bnfFile->GenerateASTParser();
+	for (auto& rule : bnfFile->GetRuleLexers())
+	{
+		const ReParser::AST::FirstSet& first = rule.second->GetFirst();
+		Re::String text;
+		for (int32 atom : first.Atoms)
+		{
+			text += RE_FORMAT("\"%s\" ", Re::String{ parser->GetAtoms()->GetAtom(atom) }.c_str());
+		}
+		for (int32 terminal : first.Terminals)
+		{
+			text += RE_FORMAT("%%%d ", terminal);
+		}
+		RE_LOG_F("%s : %s%s%s", rule.first.c_str(), text.c_str(), first.bAny ? "any " : "", rule.second->IsNullable() ? "nullable" : "");
+	}
+	RE_LOG(parser->GetProgram()->ToString());
+
+	const char* sources[] = {
+		"s0 a; s11 b; c = d; e = ; s5 f;",
+		// keywords are Name tokens too, they also try the alternatives starting with one
+		"s0 = a; s11 = ;",
+		"s3 a s4 b;",
+		"s12 a;",
+		"",
+	};
+	for (const char* source : sources)
+	{
+		const Re::String bytecode = ParseWithGrammar(*bnfFile, source, true)->GetASTTree().ToString();
+		const Re::String tree = ParseWithGrammar(*bnfFile, source, false)->GetASTTree().ToString();
+		RE_ASSERT(bytecode == tree);
+		RE_LOG_F("%s\n%s", source, bytecode.c_str());
+	}
+}
+
+void BenchmarkFirstSets()
+{
+	auto path = std::filesystem::path{__FILE__}.parent_path() / "TestFirst.bnf";
+	auto bnfFile = ReParser::BNF::BNFFile::Parse(path.string());
+	RE_ASSERT(bnfFile);
+
+	// the alternative written last is found as fast as the first one
+	for (const char* keyword : { "s0", "s11" })
+	{
+		Re::String longSource;
+		for (int32 i = 0; i < 20000; i++)
+		{
+			longSource += RE_FORMAT("%s v%d; ", keyword, i);
+		}
+		RE_LOG_F("%s : bytecode %.3f s, tree %.3f s", keyword,
+			TimeParseWithGrammar(*bnfFile, longSource, true), TimeParseWithGrammar(*bnfFile, longSource, false));
+	}
+}
@@ -4,4 +4,42 @@ void TestIni();
 
 void TestBNF();
 
-void TestASTParser();
\ No newline at end of file
+void TestASTParser();
+
+void TestTokenPatterns();
+
+void BenchmarkLexer();
+
+void TestIncrementalLex();
+
+void TestSourceSpan();
+
+void TestStreamLex();
+
+void TestUtf8Lex();
+
+void TestCommentCapture();
+
+void TestDiagnostics();
+
+void TestBatchParse();
+
+void BenchmarkBatchParse();
+
+void TestGrammarBytecode();
+
+void BenchmarkGrammarBytecode();
+
+void TestPackratMemo();
+
+void BenchmarkPackratMemo();
+
+void TestLeftRecursion();
+
+void TestPrecedenceClimbing();
+
+void BenchmarkPrecedenceClimbing();
+
+void TestFirstSets();
+
+void BenchmarkFirstSets();
\ No newline at end of file